@@ -9,8 +9,15 @@ fi
 
 echo "Compiling main.cpp..."
 
+# Optional lock contention profiler: ATCS_LOCK_PROFILE=1 ./build.sh
+EXTRA_FLAGS=""
+if [ "${ATCS_LOCK_PROFILE:-0}" = "1" ]; then
+    EXTRA_FLAGS="-DATCS_LOCK_PROFILE=1"
+    echo "Lock contention profiler enabled"
+fi
+
 # Compile with Boost libraries and threading support
-g++ -std=c++17 -pthread main.cpp -o atcs_simulation \
+g++ -std=c++20 -O2 -pthread $EXTRA_FLAGS main.cpp -o atcs_simulation \
     -lboost_system -lboost_thread
 
 # Check if compilation succeeded
@@ -1,25 +1,739 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <array>
 #include <queue>
 #include <map>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
 #include <condition_variable>
 #include <chrono>
 #include <random>
 #include <atomic>
+#include <bit>
 #include <memory>
+#include <new>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <deque>
+#include <functional>
+#include <coroutine>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <climits>
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <cmath>
+#include <filesystem>
+#include <stdexcept>
+#include <source_location>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <boost/interprocess/managed_shared_memory.hpp>
 #include <boost/interprocess/containers/vector.hpp>
 #include <boost/interprocess/sync/named_mutex.hpp>
+#include <boost/interprocess/ipc/message_queue.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ranked_index.hpp>
+
+// Lock contention profiler, compiled in with -DATCS_LOCK_PROFILE=1
+// (ATCS_LOCK_PROFILE=1 ./build.sh). Named locks are ProfiledMutex wrappers
+// taken through ProfiledLock, which captures the call site. Without the
+// option both reduce to the plain mutex and lock guard.
+#ifndef ATCS_LOCK_PROFILE
+#define ATCS_LOCK_PROFILE 0
+#endif
+
+constexpr bool kLockProfiling = ATCS_LOCK_PROFILE != 0;
+
+class LockProfiler {
+public:
+    static constexpr int kBuckets = 40;  // Power-of-two nanosecond buckets
+
+    struct SiteStats {
+        std::string function;
+        uint64_t holds = 0;
+        uint64_t totalHoldNs = 0;
+        uint64_t maxHoldNs = 0;
+    };
+
+    struct LockStats {
+        std::string name;
+        std::atomic<uint64_t> acquisitions{0};
+        std::atomic<uint64_t> contended{0};
+        std::atomic<uint64_t> totalWaitNs{0};
+        std::atomic<uint64_t> totalHoldNs{0};
+        std::atomic<uint64_t> waitBuckets[kBuckets] = {};
+        std::atomic<uint64_t> holdBuckets[kBuckets] = {};
+        std::mutex siteMutex;
+        std::map<std::pair<std::string, unsigned>, SiteStats> sites;  // (file, line)
+
+        explicit LockStats(const std::string& n) : name(n) {}
+    };
+
+    static LockProfiler& instance() {
+        static LockProfiler profiler;
+        return profiler;
+    }
+
+    // Locks with the same name share one entry, e.g. every handle on AVNMutex
+    LockStats* registerLock(const std::string& name) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto& stats : locks) {
+            if (stats->name == name) return stats.get();
+        }
+        locks.push_back(std::make_unique<LockStats>(name));
+        return locks.back().get();
+    }
+
+    static int bucketFor(uint64_t ns) {
+        int bucket = ns == 0 ? 0 : 64 - __builtin_clzll(ns);
+        return std::min(bucket, kBuckets - 1);
+    }
+
+    static void recordHold(LockStats& stats, const std::source_location& site, uint64_t holdNs) {
+        stats.totalHoldNs += holdNs;
+        stats.holdBuckets[bucketFor(holdNs)]++;
+        std::lock_guard<std::mutex> lock(stats.siteMutex);
+        SiteStats& entry = stats.sites[{site.file_name(), site.line()}];
+        if (entry.function.empty()) entry.function = site.function_name();
+        entry.holds++;
+        entry.totalHoldNs += holdNs;
+        entry.maxHoldNs = std::max(entry.maxHoldNs, holdNs);
+    }
+
+    // Upper bound of the bucket holding the given quantile
+    static std::string quantile(const std::atomic<uint64_t>* buckets, double q) {
+        uint64_t total = 0;
+        for (int i = 0; i < kBuckets; i++) total += buckets[i].load();
+        if (total == 0) return "-";
+        uint64_t target = static_cast<uint64_t>(q * (total - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; i++) {
+            seen += buckets[i].load();
+            if (seen >= target) return formatNs(i == 0 ? 0 : (1ull << i));
+        }
+        return "-";
+    }
+
+    static std::string formatNs(uint64_t ns) {
+        std::ostringstream out;
+        if (ns < 1000) out << ns << "ns";
+        else if (ns < 1000000) out << ns / 1000 << "us";
+        else if (ns < 1000000000) out << ns / 1000000 << "ms";
+        else out << ns / 1000000000 << "s";
+        return out.str();
+    }
+
+    // Locks sorted by total wait time, the cost other threads paid for them
+    void report(std::ostream& out) {
+        std::vector<LockStats*> sorted;
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (auto& stats : locks) sorted.push_back(stats.get());
+        }
+        std::sort(sorted.begin(), sorted.end(), [](LockStats* a, LockStats* b) {
+            return a->totalWaitNs.load() > b->totalWaitNs.load();
+        });
+
+        out << "\n=== LOCK CONTENTION PROFILE ===\n";
+        for (LockStats* stats : sorted) {
+            uint64_t acquisitions = stats->acquisitions.load();
+            uint64_t contended = stats->contended.load();
+            out << stats->name << ": " << acquisitions << " acquisitions, " << contended << " contended ("
+                << (acquisitions ? contended * 100 / acquisitions : 0) << "%)"
+                << ", wait total " << formatNs(stats->totalWaitNs.load())
+                << ", hold total " << formatNs(stats->totalHoldNs.load()) << "\n";
+            out << "  Wait p50/p99: " << quantile(stats->waitBuckets, 0.50) << " / "
+                << quantile(stats->waitBuckets, 0.99)
+                << " | Hold p50/p99: " << quantile(stats->holdBuckets, 0.50) << " / "
+                << quantile(stats->holdBuckets, 0.99) << "\n";
+
+            std::vector<std::pair<std::pair<std::string, unsigned>, SiteStats>> sites;
+            {
+                std::lock_guard<std::mutex> lock(stats->siteMutex);
+                sites.assign(stats->sites.begin(), stats->sites.end());
+            }
+            std::sort(sites.begin(), sites.end(), [](const auto& a, const auto& b) {
+                return a.second.totalHoldNs > b.second.totalHoldNs;
+            });
+            for (size_t i = 0; i < sites.size() && i < 3; i++) {
+                const auto& site = sites[i];
+                out << "  Holder line " << site.first.second << " " << site.second.function << ": "
+                    << site.second.holds << " holds, total " << formatNs(site.second.totalHoldNs)
+                    << ", max " << formatNs(site.second.maxHoldNs) << "\n";
+            }
+        }
+        out << "============================\n";
+    }
+
+private:
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<LockStats>> locks;
+};
+
+// Named mutex that feeds LockProfiler when profiling is compiled in. Wraps
+// std::mutex, CountingMutex or a Boost interprocess mutex alike.
+template <typename Mutex>
+class ProfiledMutex {
+private:
+    Mutex mutex;
+    LockProfiler::LockStats* stats;
+    // Only written by the current holder
+    std::chrono::steady_clock::time_point holdStart;
+    std::source_location holder;
+
+public:
+    template <typename... Args>
+    explicit ProfiledMutex(const std::string& name, Args&&... args)
+        : mutex(std::forward<Args>(args)...),
+          stats(kLockProfiling ? LockProfiler::instance().registerLock(name) : nullptr) {}
+
+    void lock(const std::source_location& site = std::source_location::current()) {
+        if constexpr (kLockProfiling) {
+            auto waitStart = std::chrono::steady_clock::now();
+            bool waited = !mutex.try_lock();
+            if (waited) {
+                mutex.lock();
+            }
+            holdStart = std::chrono::steady_clock::now();
+            holder = site;
+            stats->acquisitions++;
+            if (waited) {
+                uint64_t waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(holdStart - waitStart).count();
+                stats->contended++;
+                stats->totalWaitNs += waitNs;
+                stats->waitBuckets[LockProfiler::bucketFor(waitNs)]++;
+            } else {
+                stats->waitBuckets[0]++;
+            }
+        } else {
+            mutex.lock();
+        }
+    }
+
+    bool try_lock(const std::source_location& site = std::source_location::current()) {
+        if (!mutex.try_lock()) return false;
+        if constexpr (kLockProfiling) {
+            holdStart = std::chrono::steady_clock::now();
+            holder = site;
+            stats->acquisitions++;
+            stats->waitBuckets[0]++;
+        }
+        return true;
+    }
+
+    void unlock() {
+        if constexpr (kLockProfiling) {
+            uint64_t holdNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - holdStart).count();
+            std::source_location site = holder;
+            mutex.unlock();
+            LockProfiler::recordHold(*stats, site, holdNs);
+        } else {
+            mutex.unlock();
+        }
+    }
+
+    Mutex& native() { return mutex; }
+};
+
+// Scoped lock for ProfiledMutex that records the constructing call site
+template <typename Mutex>
+class ProfiledLock {
+private:
+    Mutex& mutex;
+
+public:
+    explicit ProfiledLock(Mutex& m, const std::source_location& site = std::source_location::current())
+        : mutex(m) {
+        mutex.lock(site);
+    }
+
+    ~ProfiledLock() { mutex.unlock(); }
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+};
+
+// Print the contention report; a no-op unless profiling is compiled in
+inline void printLockProfile() {
+    if constexpr (kLockProfiling) {
+        LockProfiler::instance().report(std::cout);
+    }
+}
 
 // Add global mutex before class declarations
-std::mutex g_console_mutex;
+ProfiledMutex<std::mutex> g_console_mutex("g_console_mutex");
+
+// Span tracer that writes Chrome trace event JSON (loads in chrome://tracing
+// and ui.perfetto.dev). Each thread appends to its own buffer; when tracing
+// is off every call site costs one relaxed load. Names and categories must
+// be string literals or otherwise outlive the tracer.
+class Tracer {
+public:
+    struct Event {
+        const char* name;
+        const char* category;
+        char type;        // 'X' complete, 'b'/'e' async begin/end
+        int64_t startNs;
+        int64_t durationNs;
+        uint64_t id;      // Async span id
+        int64_t arg;      // Flight number, or -1
+    };
+
+private:
+    struct ThreadBuffer {
+        std::mutex mutex;  // Only contended while the trace is written
+        std::vector<Event> events;
+        uint32_t tid;
+        std::string name;
+    };
+
+    static constexpr size_t kMaxEventsPerThread = 4 * 1024 * 1024;
+
+    std::atomic<bool> enabled;
+    std::string path;
+    std::chrono::steady_clock::time_point origin;
+    std::mutex bufferMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> threadBuffers;
+    std::atomic<uint64_t> dropped;
+
+    static inline thread_local ThreadBuffer* cachedBuffer = nullptr;
+    static inline thread_local const char* pendingThreadName = nullptr;
+
+    ThreadBuffer& localBuffer() {
+        if (!cachedBuffer) {
+            auto buffer = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            buffer->tid = static_cast<uint32_t>(threadBuffers.size() + 1);
+            buffer->name = pendingThreadName ? pendingThreadName : "thread-" + std::to_string(buffer->tid);
+            threadBuffers.push_back(buffer);
+            cachedBuffer = buffer.get();
+        }
+        return *cachedBuffer;
+    }
+
+    void push(const Event& event) {
+        ThreadBuffer& buffer = localBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if (buffer.events.size() >= kMaxEventsPerThread) {
+            dropped++;
+            return;
+        }
+        buffer.events.push_back(event);
+    }
+
+public:
+    Tracer() : enabled(false), dropped(0) {}
+
+    // JSON string body; also used by the run report
+    static void writeEscaped(std::ostream& out, const char* text) {
+        for (; *text; text++) {
+            if (*text == '"' || *text == '\\') out << '\\';
+            out << *text;
+        }
+    }
+
+    bool active() const { return enabled.load(std::memory_order_relaxed); }
+
+    int64_t nowNs() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - origin).count();
+    }
+
+    void start(const std::string& outputPath) {
+        path = outputPath;
+        origin = std::chrono::steady_clock::now();
+        enabled.store(true);
+    }
+
+    // Label the calling thread in the viewer; call before its first event
+    void nameThread(const char* name) {
+        pendingThreadName = name;
+        if (cachedBuffer) {
+            std::lock_guard<std::mutex> lock(cachedBuffer->mutex);
+            cachedBuffer->name = name;
+        }
+    }
+
+    void complete(const char* name, const char* category, int64_t startNs, int64_t arg = -1) {
+        if (!active()) return;
+        push({name, category, 'X', startNs, nowNs() - startNs, 0, arg});
+    }
+
+    void asyncBegin(const char* name, const char* category, uint64_t id, int64_t arg = -1) {
+        if (!active()) return;
+        push({name, category, 'b', nowNs(), 0, id, arg});
+    }
+
+    void asyncEnd(const char* name, const char* category, uint64_t id, int64_t arg = -1) {
+        if (!active()) return;
+        push({name, category, 'e', nowNs(), 0, id, arg});
+    }
+
+    // Stop recording and write every thread's events to the trace file
+    bool finish() {
+        if (!enabled.exchange(false)) return true;
+
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) {
+            std::cerr << "Failed to write trace " << path << std::endl;
+            return false;
+        }
+
+        size_t written = 0;
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"ATCS\"}}";
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        for (const auto& buffer : threadBuffers) {
+            std::lock_guard<std::mutex> eventsLock(buffer->mutex);
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"args\":{\"name\":\"";
+            writeEscaped(out, buffer->name.c_str());
+            out << "\"}}";
+            for (const Event& event : buffer->events) {
+                out << ",\n{\"name\":\"";
+                writeEscaped(out, event.name);
+                out << "\",\"cat\":\"" << event.category << "\",\"ph\":\"" << event.type
+                    << "\",\"pid\":1,\"tid\":" << buffer->tid
+                    << ",\"ts\":" << event.startNs / 1000 << "." << std::setw(3) << std::setfill('0')
+                    << event.startNs % 1000 << std::setfill(' ');
+                if (event.type == 'X') {
+                    out << ",\"dur\":" << event.durationNs / 1000 << "." << std::setw(3) << std::setfill('0')
+                        << event.durationNs % 1000 << std::setfill(' ');
+                } else {
+                    out << ",\"id\":" << event.id;
+                }
+                if (event.arg >= 0) {
+                    out << ",\"args\":{\"flight\":" << event.arg << "}";
+                }
+                out << "}";
+                written++;
+            }
+            buffer->events.clear();
+            buffer->events.shrink_to_fit();
+        }
+        out << "\n]}\n";
+
+        ProfiledLock consoleLock(g_console_mutex);
+        std::cout << "Trace: " << written << " events written to " << path;
+        if (dropped.load() > 0) {
+            std::cout << " (" << dropped.load() << " dropped)";
+        }
+        std::cout << "\n";
+        return true;
+    }
+};
+
+Tracer g_tracer;
+
+// Records a complete span for the enclosing scope when tracing is on
+class TraceScope {
+private:
+    const char* name;
+    const char* category;
+    int64_t startNs;
+    int64_t arg;
+
+public:
+    TraceScope(const char* n, const char* c, int64_t a = -1)
+        : name(n), category(c), startNs(g_tracer.active() ? g_tracer.nowNs() : -1), arg(a) {}
+
+    ~TraceScope() {
+        if (startNs >= 0) {
+            g_tracer.complete(name, category, startNs, arg);
+        }
+    }
+};
+
+// Allocation tracker, switched on with --alloc-profile. The global operator
+// new/delete below feed it; while it is off they cost one relaxed load on
+// top of malloc/free. Each thread counts into its own cache line, tagged
+// with the subsystem it is working for, and flight lifecycles also count
+// into their coroutine frame (see FlightTask).
+enum class AllocSubsystem : uint8_t {
+    Other, Main, Generator, Lifecycle, Timer, Dispatch, Airspace,
+    Faults, Violations, Telemetry, Events, Payments, Ipc, Control
+};
+constexpr int kAllocSubsystemCount = 14;
+
+struct AllocCount {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+class AllocTracker {
+private:
+    struct alignas(64) ThreadCounters {
+        std::atomic<uint64_t> allocations[kAllocSubsystemCount];
+        std::atomic<uint64_t> bytes[kAllocSubsystemCount];
+        std::atomic<uint64_t> frees;
+        std::atomic<uint64_t> freedBytes;
+    };
+
+    struct LifecycleRecord {
+        int flightNumber;
+        AllocCount count;
+    };
+
+    // Threads past the last slot share it; the counters stay atomic for that
+    static constexpr size_t kMaxThreads = 256;
+
+    static inline std::atomic<bool> enabled{false};
+    static inline ThreadCounters slots[kMaxThreads];
+    static inline std::atomic<size_t> slotsUsed{0};
+    static inline std::mutex lifecycleMutex;
+    static inline std::vector<LifecycleRecord> lifecycles;
+
+    static inline thread_local ThreadCounters* threadSlot = nullptr;
+
+    static ThreadCounters& localCounters() {
+        if (!threadSlot) {
+            threadSlot = &slots[std::min(slotsUsed++, kMaxThreads - 1)];
+        }
+        return *threadSlot;
+    }
+
+public:
+    static inline thread_local AllocSubsystem subsystem = AllocSubsystem::Other;
+    static inline thread_local AllocCount* lifecycleCount = nullptr;
+
+    static bool active() { return enabled.load(std::memory_order_relaxed); }
+    static void start() { enabled = true; }
+
+    // Subsystem for everything the calling thread allocates outside an AllocScope
+    static void tagThread(AllocSubsystem tag) { subsystem = tag; }
+
+    static void onAllocate(void* ptr) {
+        if (!active()) return;
+        size_t size = malloc_usable_size(ptr);
+        ThreadCounters& counters = localCounters();
+        int tag = static_cast<int>(subsystem);
+        counters.allocations[tag].fetch_add(1, std::memory_order_relaxed);
+        counters.bytes[tag].fetch_add(size, std::memory_order_relaxed);
+        if (lifecycleCount) {
+            lifecycleCount->allocations++;
+            lifecycleCount->bytes += size;
+        }
+    }
+
+    static void onFree(void* ptr) {
+        if (!ptr || !active()) return;
+        ThreadCounters& counters = localCounters();
+        counters.frees.fetch_add(1, std::memory_order_relaxed);
+        counters.freedBytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+    }
+
+    // Called as a lifecycle's coroutine frame is destroyed
+    static void endLifecycle(int flightNumber, const AllocCount& count) {
+        if (lifecycleCount == &count) lifecycleCount = nullptr;
+        if (!active()) return;
+        std::lock_guard<std::mutex> lock(lifecycleMutex);
+        lifecycles.push_back({flightNumber, count});
+    }
+
+    // Allocations per subsystem and per lifecycle, and per `unit` of work
+    // (flight, payment, ...) when units > 0. Returns false if the
+    // allocations per unit exceed budget (0 disables the check).
+    static bool report(std::ostream& out, const char* unit, uint64_t units, double budget) {
+        static const char* const names[kAllocSubsystemCount] = {
+            "other", "main", "generator", "lifecycle", "timer", "dispatch", "airspace",
+            "faults", "violations", "telemetry", "events", "payments", "ipc", "control"};
+        AllocCount bySubsystem[kAllocSubsystemCount];
+        uint64_t frees = 0;
+        uint64_t freedBytes = 0;
+        size_t used = std::min(slotsUsed.load(), kMaxThreads);
+        for (size_t i = 0; i < used; i++) {
+            for (int tag = 0; tag < kAllocSubsystemCount; tag++) {
+                bySubsystem[tag].allocations += slots[i].allocations[tag].load(std::memory_order_relaxed);
+                bySubsystem[tag].bytes += slots[i].bytes[tag].load(std::memory_order_relaxed);
+            }
+            frees += slots[i].frees.load(std::memory_order_relaxed);
+            freedBytes += slots[i].freedBytes.load(std::memory_order_relaxed);
+        }
+        AllocCount sum;
+        for (const AllocCount& count : bySubsystem) {
+            sum.allocations += count.allocations;
+            sum.bytes += count.bytes;
+        }
+
+        std::vector<LifecycleRecord> records;
+        {
+            std::lock_guard<std::mutex> lock(lifecycleMutex);
+            records = lifecycles;
+        }
+
+        std::ios oldState(nullptr);
+        oldState.copyfmt(out);
+        out << std::fixed << std::setprecision(1);
+        out << "\n=== ALLOCATION PROFILE ===\n";
+        out << std::left << std::setw(12) << "Subsystem" << std::right << std::setw(14) << "Allocations"
+            << std::setw(14) << "KB" << std::setw(12) << "Avg bytes" << "\n";
+        for (int tag = 0; tag < kAllocSubsystemCount; tag++) {
+            const AllocCount& count = bySubsystem[tag];
+            if (count.allocations == 0) continue;
+            out << std::left << std::setw(12) << names[tag] << std::right << std::setw(14) << count.allocations
+                << std::setw(14) << count.bytes / 1024.0
+                << std::setw(12) << static_cast<double>(count.bytes) / count.allocations << "\n";
+        }
+        out << "Total: " << sum.allocations << " allocations, " << sum.bytes / 1024.0 << " KB | "
+            << frees << " frees, net " << (static_cast<double>(sum.bytes) - freedBytes) / 1024.0 << " KB\n";
+
+        if (!records.empty()) {
+            std::sort(records.begin(), records.end(), [](const auto& a, const auto& b) {
+                return a.count.allocations < b.count.allocations;
+            });
+            auto percentile = [&](double p) {
+                return records[static_cast<size_t>(p * (records.size() - 1) + 0.5)].count.allocations;
+            };
+            uint64_t lifecycleAllocations = 0;
+            uint64_t lifecycleBytes = 0;
+            for (const auto& record : records) {
+                lifecycleAllocations += record.count.allocations;
+                lifecycleBytes += record.count.bytes;
+            }
+            out << "Lifecycles: " << records.size() << " | mean "
+                << static_cast<double>(lifecycleAllocations) / records.size() << " allocations, "
+                << static_cast<double>(lifecycleBytes) / records.size() << " bytes | p50/p99 "
+                << percentile(0.50) << "/" << percentile(0.99) << " | max " << records.back().count.allocations
+                << " (flight " << records.back().flightNumber << ")\n";
+        }
+
+        bool withinBudget = true;
+        if (units > 0) {
+            double perUnit = static_cast<double>(sum.allocations) / units;
+            out << "Per " << unit << ": " << perUnit << " allocations, "
+                << static_cast<double>(sum.bytes) / units << " bytes (" << units << " " << unit << "s)\n";
+            if (budget > 0 && perUnit > budget) {
+                out << "BUDGET EXCEEDED: " << perUnit << " allocations per " << unit << " > " << budget << "\n";
+                withinBudget = false;
+            }
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        out << "Peak RSS: " << usage.ru_maxrss << " KB\n";
+        out << "============================\n";
+        out.copyfmt(oldState);
+        return withinBudget;
+    }
+};
+
+// Charges the enclosing scope's allocations to a subsystem. Not for use
+// across a co_await; the scope would leak onto whatever the thread runs next.
+class AllocScope {
+private:
+    AllocSubsystem saved;
+
+public:
+    explicit AllocScope(AllocSubsystem tag) : saved(AllocTracker::subsystem) { AllocTracker::subsystem = tag; }
+    ~AllocScope() { AllocTracker::subsystem = saved; }
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+};
+
+// Replacement allocation functions; the array and nothrow forms forward here
+static void* trackedAllocate(std::size_t size, std::size_t alignment) {
+    if (size == 0) size = 1;
+    while (true) {
+        void* ptr = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                        ? std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1))
+                        : std::malloc(size);
+        if (ptr) {
+            AllocTracker::onAllocate(ptr);
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(std::size_t size) { return trackedAllocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return trackedAllocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* ptr) noexcept {
+    AllocTracker::onFree(ptr);
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept { ::operator delete(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { ::operator delete(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { ::operator delete(ptr); }
+
+// Low-latency mode: which cores the runway dispatcher and the AVN/logging
+// workers run on, and whether the dispatcher spins instead of sleeping.
+// Set from the command line before any thread starts.
+struct LowLatencyConfig {
+    int dispatcherCore = -1;   // -1 leaves the thread unpinned
+    int workerCore = -1;       // AVN process, telemetry encoder, IPC settlement
+    bool busyPoll = false;
+    int realtimePriority = 0;  // SCHED_FIFO priority for the dispatcher; 0 keeps SCHED_OTHER
+    bool reportLatency = false;
+
+    bool enabled() const {
+        return dispatcherCore >= 0 || workerCore >= 0 || busyPoll || realtimePriority > 0 || reportLatency;
+    }
+};
+
+LowLatencyConfig g_lowLatency;
+
+// Pin the calling thread to one core; -1 is a no-op
+inline bool pinCurrentThread(int core, const char* role) {
+    if (core < 0) return true;
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(core, &cores);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores);
+    if (rc != 0) {
+        std::cerr << "Cannot pin " << role << " to core " << core << ": " << std::strerror(rc) << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Move the calling thread to SCHED_FIFO. Without CAP_SYS_NICE this fails
+// and the thread keeps its normal policy.
+inline bool useRealtimeScheduling(int priority, const char* role) {
+    sched_param param{};
+    param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO),
+                                      sched_get_priority_max(SCHED_FIFO));
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        std::cerr << "SCHED_FIFO unavailable for " << role << ": " << std::strerror(rc) << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Spin-wait hint so a busy-polling core yields pipeline resources
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
 
 // Forward declarations
 class Flight;
@@ -42,6 +756,54 @@ enum class EmergencyType {
     VIP
 };
 
+constexpr int kEmergencyTypeCount = 5;
+
+// Runway service promised to each EmergencyType. Preempting emergencies
+// (inbound medical and low-fuel flights) get a runway reserved while they
+// hold, and other traffic is only granted it if it will be clear in time.
+// Every emergency's grant latency is tracked against its SLO.
+struct EmergencyPolicy {
+    const char* name;
+    bool preempts;       // Reserves a runway and ignores other reservations' hold-off
+    int64_t grantSloMs;  // Runway request to grant, simulated ms; 0 if untracked
+};
+
+inline EmergencyPolicy emergencyPolicy(EmergencyType type) {
+    switch (type) {
+        case EmergencyType::Military: return {"Military", false, 60000};
+        case EmergencyType::Medical: return {"Medical", true, 20000};
+        case EmergencyType::DiversionOrLowFuel: return {"Diversion/Low Fuel", true, 20000};
+        case EmergencyType::VIP: return {"VIP", false, 90000};
+        default: return {"None", false, 0};
+    }
+}
+
+// Ground faults that send an aircraft to maintenance
+enum class GroundFault {
+    BrakeFailure,
+    HydraulicLeak,
+    APUMalfunction,
+    SteeringFault
+};
+constexpr int kGroundFaultCount = 4;
+
+inline const char* groundFaultName(GroundFault fault) {
+    switch (fault) {
+        case GroundFault::BrakeFailure: return "Brake failure";
+        case GroundFault::HydraulicLeak: return "Hydraulic leak";
+        case GroundFault::APUMalfunction: return "APU malfunction";
+        case GroundFault::SteeringFault: return "Steering system fault";
+    }
+    return "Unknown fault";
+}
+
+// How the generator spaces flights on each schedule
+enum class ArrivalProcess {
+    Scheduled,  // Fixed schedule intervals, or Poisson at an offered rate
+    Poisson,
+    Bursty      // Poisson bursts of geometrically many flights
+};
+
 // Enum for Flight Direction
 enum class FlightDirection {
     NorthArrival,
@@ -50,6 +812,65 @@ enum class FlightDirection {
     WestDeparture
 };
 
+// Enum for the runway queue a flight waits in; each runway serves one class
+// first and the others as overflow
+enum class RunwayClass {
+    Arrival,
+    Departure,
+    CargoEmergency
+};
+
+const int kRunwayClassCount = 3;
+
+// Runway sets are bitmasks indexed by runway ID, which caps a layout at 64
+constexpr int kMaxRunways = 64;
+using RunwayMask = uint64_t;
+
+constexpr uint8_t runwayClassBit(RunwayClass runwayClass) {
+    return static_cast<uint8_t>(1u << static_cast<int>(runwayClass));
+}
+constexpr uint8_t kAllRunwayClasses = (1u << kRunwayClassCount) - 1;
+
+// One runway of an airport layout: the class it serves first and every
+// class it may serve at all
+struct RunwaySpec {
+    RunwayClass home;
+    uint8_t capabilities;        // runwayClassBit per class served
+    const char* name = nullptr;  // Generated from the ID and role if null
+};
+
+struct RunwayClassMasks {
+    std::array<RunwayMask, kRunwayClassCount> capable{};  // Runways that may serve each class
+    std::array<RunwayMask, kRunwayClassCount> home{};     // Runways that serve each class first
+};
+
+// Per-class runway sets of a layout. constexpr, so a fixed layout's masks
+// are constants baked into the binary.
+template <typename Layout>
+constexpr RunwayClassMasks runwayClassMasks(const Layout& layout) {
+    RunwayClassMasks masks;
+    size_t id = 0;
+    for (const RunwaySpec& runway : layout) {
+        for (int c = 0; c < kRunwayClassCount; c++) {
+            if (runway.capabilities & (1u << c)) masks.capable[c] |= RunwayMask{1} << id;
+        }
+        masks.home[static_cast<int>(runway.home)] |= RunwayMask{1} << id;
+        id++;
+    }
+    return masks;
+}
+
+// The built-in airport: one runway per class, any class may overflow onto any runway
+constexpr std::array<RunwaySpec, 3> kDefaultRunwayLayout = {{
+    {RunwayClass::Arrival, kAllRunwayClasses, "RWY-A (North-South Arrivals)"},
+    {RunwayClass::Departure, kAllRunwayClasses, "RWY-B (East-West Departures)"},
+    {RunwayClass::CargoEmergency, kAllRunwayClasses, "RWY-C (Cargo/Emergency/Overflow)"},
+}};
+constexpr RunwayClassMasks kDefaultRunwayMasks = runwayClassMasks(kDefaultRunwayLayout);
+static_assert(kDefaultRunwayLayout.size() <= kMaxRunways, "runway layout exceeds the mask width");
+static_assert(kDefaultRunwayMasks.capable[0] == 0b111 && kDefaultRunwayMasks.home[2] == 0b100,
+              "default layout masks");
+
 // Enum for Flight Phase
 enum class FlightPhase {
     Holding,
@@ -63,6 +884,19 @@ enum class FlightPhase {
     Departure
 };
 
+// Enum for the kind of violation an AVN was issued for
+enum class ViolationKind {
+    Speed,
+    Separation
+};
+
+// Display names indexed by FlightPhase, for records that store the phase as an integer
+const int kFlightPhaseCount = 9;
+const char* const kFlightPhaseNames[kFlightPhaseCount] = {
+    "Holding", "Approach", "Landing", "Taxi", "At Gate",
+    "Takeoff Roll", "Climb", "Cruise", "Departure"
+};
+
 // Airline class
 class Airline {
 public:
@@ -70,9 +904,11 @@ public:
     AircraftType type;
     int totalAircrafts;
     int flightsInOperation;
+    EmergencyType specialty;  // Emergency this airline alone answers, or None
 
-    Airline(const std::string& n, AircraftType t, int total, int flights)
-        : name(n), type(t), totalAircrafts(total), flightsInOperation(flights) {}
+    Airline(const std::string& n, AircraftType t, int total, int flights,
+            EmergencyType spec = EmergencyType::None)
+        : name(n), type(t), totalAircrafts(total), flightsInOperation(flights), specialty(spec) {}
 };
 
 // Flight class
@@ -82,8 +918,9 @@ public:
     Airline* airline;
     AircraftType aircraftType;
     FlightDirection direction;
-    FlightPhase phase;
-    float speed; // km/h
+    // Written by the lifecycle, read unlocked by the airspace thread
+    std::atomic<FlightPhase> phase;
+    std::atomic<float> speed; // km/h
     bool violationActive;
     std::string violationReason;
     std::chrono::system_clock::time_point scheduledTime;
@@ -92,23 +929,64 @@ public:
     bool runwayOccupied;
     EmergencyType emergencyType;
     int priorityLevel; // 1-4, with 1 being highest
-    bool hasFault;
+    std::atomic<bool> hasFault;
     std::string faultDescription;
-    int estimatedWaitTime;
     std::vector<int> avnIDs;  // Track AVN IDs for this flight
+    std::coroutine_handle<> runwayWaiter;  // Lifecycle suspended on a runway grant
+    bool inRunwayQueue;
+    std::atomic<bool> lifecycleComplete;
+    std::chrono::steady_clock::time_point phaseStart;
+    std::chrono::steady_clock::time_point queuedAt;  // When the flight joined a runway queue
+    int gateAssigned;  // -1 if none
+    int reservedRunway;  // Held for this inbound emergency, -1 if none
+    int64_t delayMs;     // Runway and gate waits so far, in simulated ms
+    int runwayUsed;      // Runway entered, -1 if none yet
+    int64_t runwayEnterMs;  // Simulated ms; -1 until entered or released
+    int64_t runwayExitMs;
+
+    // Airborne position model: km from the airport, metres above it
+    bool positioned;
+    float posX;
+    float posY;
+    float altitude;
+    float heading;     // Radians, counter-clockwise from east
+    bool tracePhaseOpen;  // A trace span is open for the current phase
 
     Flight(int num, Airline* al, AircraftType at, FlightDirection dir, 
            std::chrono::system_clock::time_point sched, EmergencyType emType = EmergencyType::None)
         : flightNumber(num), airline(al), aircraftType(at), direction(dir), phase(FlightPhase::Holding),
           speed(0.0f), violationActive(false), runwayAssigned(-1), runwayOccupied(false),
-          emergencyType(emType), priorityLevel(calculatePriority()), hasFault(false), estimatedWaitTime(0)
+          emergencyType(emType), priorityLevel(calculatePriority()), hasFault(false),
+          inRunwayQueue(false), lifecycleComplete(false), phaseStart(std::chrono::steady_clock::now()),
+          queuedAt(phaseStart), gateAssigned(-1), reservedRunway(-1),
+          delayMs(0), runwayUsed(-1), runwayEnterMs(-1), runwayExitMs(-1),
+          positioned(false), posX(0.0f), posY(0.0f), altitude(0.0f), heading(0.0f),
+          tracePhaseOpen(false)
     {
         scheduledTime = sched;
         actualTime = sched;
     }
 
     void updatePhase(FlightPhase newPhase) {
+        traceLeavePhase();
         phase = newPhase;
+        phaseStart = std::chrono::steady_clock::now();
+        traceEnterPhase();
+    }
+
+    // Each phase is an async trace span keyed by flight number
+    void traceEnterPhase() {
+        if (g_tracer.active() && !tracePhaseOpen) {
+            g_tracer.asyncBegin(kFlightPhaseNames[static_cast<int>(phase.load())], "flight", flightNumber, flightNumber);
+            tracePhaseOpen = true;
+        }
+    }
+
+    void traceLeavePhase() {
+        if (tracePhaseOpen) {
+            g_tracer.asyncEnd(kFlightPhaseNames[static_cast<int>(phase.load())], "flight", flightNumber, flightNumber);
+            tracePhaseOpen = false;
+        }
     }
 
     void updateSpeed(float newSpeed) {
@@ -127,7 +1005,12 @@ public:
         }
     }
     
-    std::string getPhaseString() const {
+    std::string getPhaseString() const { return phaseName(phase); }
+    std::string getDirectionString() const { return directionName(direction); }
+    std::string getAircraftTypeString() const { return aircraftTypeName(aircraftType); }
+    std::string getEmergencyTypeString() const { return emergencyTypeName(emergencyType); }
+
+    static const char* phaseName(FlightPhase phase) {
         switch (phase) {
             case FlightPhase::Holding: return "Holding";
             case FlightPhase::Approach: return "Approach";
@@ -142,7 +1025,7 @@ public:
         }
     }
     
-    std::string getDirectionString() const {
+    static const char* directionName(FlightDirection direction) {
         switch (direction) {
             case FlightDirection::NorthArrival: return "North Arrival";
             case FlightDirection::SouthArrival: return "South Arrival";
@@ -152,8 +1035,8 @@ public:
         }
     }
     
-    std::string getAircraftTypeString() const {
-        switch (aircraftType) {
+    static const char* aircraftTypeName(AircraftType type) {
+        switch (type) {
             case AircraftType::Commercial: return "Commercial";
             case AircraftType::Cargo: return "Cargo";
             case AircraftType::Emergency: return "Emergency";
@@ -161,8 +1044,8 @@ public:
         }
     }
     
-    std::string getEmergencyTypeString() const {
-        switch (emergencyType) {
+    static const char* emergencyTypeName(EmergencyType type) {
+        switch (type) {
             case EmergencyType::None: return "None";
             case EmergencyType::Military: return "Military";
             case EmergencyType::Medical: return "Medical";
@@ -178,10 +1061,14 @@ class Runway {
 public:
     int id;
     std::string name;
-    std::mutex runwayMutex;
+    RunwayClass homeClass;  // Served before overflow traffic
+    uint8_t capabilities;   // runwayClassBit per class this runway may serve
+    ProfiledMutex<std::mutex> runwayMutex;
     std::atomic<bool> occupied;
 
-    Runway(int i, const std::string& n) : id(i), name(n), occupied(false) {}
+    Runway(int i, const std::string& n, RunwayClass home, uint8_t caps = kAllRunwayClasses)
+        : id(i), name(n), homeClass(home), capabilities(caps | runwayClassBit(home)),
+          runwayMutex("runwayMutex " + n), occupied(false) {}
 
     bool tryAcquire() {
         if (runwayMutex.try_lock()) {
@@ -254,6 +1141,7 @@ public:
 
 // Shared memory structures for IPC
 namespace bip = boost::interprocess;
+namespace bmi = boost::multi_index;
 
 struct SharedAVN {
     int avnID;
@@ -266,8 +1154,13 @@ struct SharedAVN {
     double fineAmount;
     bool paymentStatus;
     time_t dueDate;
+    int flightPhase;  // FlightPhase in which the violation occurred
+    int violationKind;
 };
 
+// Sized for the multi-process benchmark; pages are only touched as AVNs are added
+const size_t kAVNSegmentSize = 64 * 1024 * 1024;
+
 typedef bip::allocator<SharedAVN, bip::managed_shared_memory::segment_manager> ShmemAllocator;
 typedef bip::vector<SharedAVN, ShmemAllocator> SharedAVNVector;
 
@@ -279,39 +1172,245 @@ struct SharedCounters {
 
 // Add before ATCSController class definition
 struct SharedRunwayStatus {
-    std::atomic<bool> runwayOccupied[3];  // For 3 runways
-    SharedRunwayStatus() {
-        for (int i = 0; i < 3; i++) {
-            runwayOccupied[i] = false;
-        }
-    }
+    std::atomic<uint64_t> occupiedMask;  // Bit per runway ID, set while a movement is on it
+    SharedRunwayStatus() : occupiedMask(0) {}
 };
 
-// AVN Generator class
-class AVNGenerator {
+// Checkpoint file layout. Every section is a flat array of fixed-size records
+// aligned to 8 bytes, so a restore reads the file straight out of a mapping.
+const char kCheckpointMagic[8] = {'A', 'T', 'C', 'S', 'C', 'K', 'P', 'T'};
+const uint32_t kCheckpointVersion = 5;
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flightCount;
+    uint32_t queueCount;
+    uint32_t avnIdCount;
+    uint32_t avnCount;
+    uint32_t scheduleCount;
+    uint32_t runwayCount;
+    uint32_t stringPoolSize;
+    int64_t simulationElapsedMs;
+    uint32_t nextFlightNumber;
+    int32_t avnCounter;
+    uint64_t flightsOffset;
+    uint64_t queueOffset;       // int32 flight indices in runway queue pop order
+    uint64_t avnIdsOffset;      // int32 AVN IDs referenced by CheckpointFlight
+    uint64_t avnsOffset;        // SharedAVN records
+    uint64_t schedulesOffset;   // int64 milliseconds until each schedule's next spawn
+    uint64_t runwaysOffset;     // int32 owning flight number per runway, -1 if free
+    uint64_t stringPoolOffset;  // violation reasons and fault descriptions
+};
+
+enum CheckpointFlightFlags : uint8_t {
+    kCheckpointViolationActive = 1 << 0,
+    kCheckpointHasFault = 1 << 1,
+    kCheckpointLifecycleComplete = 1 << 2,
+    kCheckpointRunwayOccupied = 1 << 3,
+    kCheckpointInRunwayQueue = 1 << 4
+};
+
+struct CheckpointFlight {
+    int32_t flightNumber;
+    int32_t airlineIndex;
+    uint8_t aircraftType;
+    uint8_t direction;
+    uint8_t phase;
+    uint8_t emergencyType;
+    uint8_t priorityLevel;
+    uint8_t flags;
+    int16_t gateAssigned;
+    float speed;
+    int32_t runwayAssigned;
+    int32_t estimatedWaitTime;  // Predicted runway wait in ms when saved; informational
+    int32_t runwayUsed;
+    int64_t scheduledTimeMs;
+    int64_t actualTimeMs;
+    int64_t phaseElapsedMs;
+    int64_t delayMs;
+    int64_t runwayEnterMs;      // Simulated ms, like simulationElapsedMs
+    int64_t runwayExitMs;
+    uint32_t avnIdOffset;
+    uint32_t avnIdCount;
+    uint32_t violationOffset;
+    uint32_t violationLength;
+    uint32_t faultOffset;
+    uint32_t faultLength;
+};
+
+// Columnar copy of the AVN history for analytics. Each SharedAVN field lives
+// in its own contiguous array so aggregates are tight loops over a few
+// columns that the compiler can vectorize.
+class AVNAnalytics {
 private:
-    std::mutex avnMutex;
-    bip::managed_shared_memory segment;
-    SharedAVNVector* avnVector;
-    SharedCounters* sharedCounters;
-    bip::named_mutex namedMutex;
+    std::vector<int32_t> avnID;
+    std::vector<uint16_t> airlineID;
+    std::vector<uint8_t> aircraftType;
+    std::vector<uint8_t> phase;
+    std::vector<float> recordedSpeed;
+    std::vector<float> permissibleSpeed;
+    std::vector<double> fineAmount;
+    std::vector<int64_t> issueTime;
+    std::vector<int64_t> dueDate;
+    std::vector<uint8_t> paid;          // 0 or 1, stored as bytes for branch-free scans
+    std::vector<uint32_t> sharedIndex;  // Position of the row in the shared AVN vector
+
+    std::vector<std::string> airlineNames;
+    std::map<std::string, uint16_t, std::less<>> airlineLookup;
+    uint16_t lastAirline;
+    std::vector<uint32_t> unpaidRows;   // Rows whose paid flag may still change
+    size_t ingestedShared;              // Shared vector entries already copied
+
+    uint16_t internAirline(const char* name) {
+        // AVNs arrive in bursts from the same airline; skip the map lookup then
+        if (!airlineNames.empty() && airlineNames[lastAirline] == name) {
+            return lastAirline;
+        }
+        auto it = airlineLookup.find(name);
+        if (it != airlineLookup.end()) {
+            lastAirline = it->second;
+            return lastAirline;
+        }
+        uint16_t id = static_cast<uint16_t>(airlineNames.size());
+        airlineNames.push_back(name);
+        airlineLookup.emplace(name, id);
+        lastAirline = id;
+        return id;
+    }
 
 public:
-    AVNGenerator() : 
-        segment(bip::open_or_create, "AVNSharedMemory", 65536),
-        namedMutex(bip::open_or_create, "AVNMutex")
-    {
-        // Initialize shared memory for AVNs
-        ShmemAllocator alloc_inst(segment.get_segment_manager());
-        avnVector = segment.find_or_construct<SharedAVNVector>("AVNVector")(alloc_inst);
-        sharedCounters = segment.find_or_construct<SharedCounters>("Counters")();
+    AVNAnalytics() : lastAirline(0), ingestedShared(0) {}
+
+    void append(const SharedAVN& avn, uint32_t indexInShared) {
+        uint32_t row = static_cast<uint32_t>(avnID.size());
+        avnID.push_back(avn.avnID);
+        airlineID.push_back(internAirline(avn.airlineName));
+        aircraftType.push_back(static_cast<uint8_t>(avn.aircraftType));
+        phase.push_back(static_cast<uint8_t>(avn.flightPhase));
+        recordedSpeed.push_back(avn.recordedSpeed);
+        permissibleSpeed.push_back(avn.permissibleSpeed);
+        fineAmount.push_back(avn.fineAmount);
+        issueTime.push_back(avn.issueDateTime);
+        dueDate.push_back(avn.dueDate);
+        paid.push_back(avn.paymentStatus ? 1 : 0);
+        sharedIndex.push_back(indexInShared);
+        if (!avn.paymentStatus) {
+            unpaidRows.push_back(row);
+        }
     }
 
-    int generateAVN(Flight* flight, float permissibleSpeed) {
-        std::lock_guard<std::mutex> lock(avnMutex);
-        
-        double baseAmount = 0.0;
-        switch (flight->aircraftType) {
+    // Copy new AVNs and payment changes from shared memory. The caller holds
+    // the AVN named mutex. Cost is O(new AVNs + unpaid AVNs), not O(history).
+    void refresh(const SharedAVNVector& shared) {
+        for (size_t i = ingestedShared; i < shared.size(); i++) {
+            append(shared[i], static_cast<uint32_t>(i));
+        }
+        ingestedShared = shared.size();
+
+        for (size_t i = 0; i < unpaidRows.size();) {
+            uint32_t row = unpaidRows[i];
+            uint32_t index = sharedIndex[row];
+            if (index < shared.size() && shared[index].avnID == avnID[row] && shared[index].paymentStatus) {
+                paid[row] = 1;
+                unpaidRows[i] = unpaidRows.back();
+                unpaidRows.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    size_t size() const { return avnID.size(); }
+    const std::vector<std::string>& airlines() const { return airlineNames; }
+
+    // Total unpaid fines per airline, indexed like airlines()
+    std::vector<double> outstandingFinesByAirline() const {
+        std::vector<double> totals(airlineNames.size(), 0.0);
+        const size_t rows = fineAmount.size();
+        const uint16_t* airline = airlineID.data();
+        const double* fine = fineAmount.data();
+        const uint8_t* isPaid = paid.data();
+        for (size_t i = 0; i < rows; i++) {
+            totals[airline[i]] += fine[i] * (1 - isPaid[i]);
+        }
+        return totals;
+    }
+
+    // Violation counts bucketed by phase and hour of day (UTC offset applied)
+    std::vector<uint64_t> violationsByPhaseAndHour(long utcOffsetSeconds) const {
+        std::vector<uint64_t> counts(kFlightPhaseCount * 24, 0);
+        const size_t rows = issueTime.size();
+        const int64_t* issued = issueTime.data();
+        const uint8_t* phases = phase.data();
+        for (size_t i = 0; i < rows; i++) {
+            // Issue times are post-epoch, so unsigned division is safe and cheaper
+            uint64_t local = static_cast<uint64_t>(issued[i] + utcOffsetSeconds);
+            int hour = static_cast<int>(local / 3600 % 24);
+            uint8_t p = phases[i] < kFlightPhaseCount ? phases[i] : 0;
+            counts[p * 24 + hour]++;
+        }
+        return counts;
+    }
+
+    // Unpaid AVNs whose due date is before `now`
+    uint64_t overdueCount(int64_t now) const {
+        const size_t rows = dueDate.size();
+        const int64_t* due = dueDate.data();
+        const uint8_t* isPaid = paid.data();
+        uint64_t count = 0;
+        for (size_t i = 0; i < rows; i++) {
+            count += static_cast<uint64_t>((isPaid[i] == 0) & (due[i] < now));
+        }
+        return count;
+    }
+
+    struct FineTotals {
+        uint64_t issued = 0;
+        uint64_t paid = 0;
+        double finesIssued = 0.0;
+        double finesPaid = 0.0;
+    };
+
+    // AVNs and fines issued and paid per airline, indexed like airlines()
+    std::vector<FineTotals> finesByAirline() const {
+        std::vector<FineTotals> totals(airlineNames.size());
+        const size_t rows = fineAmount.size();
+        for (size_t i = 0; i < rows; i++) {
+            FineTotals& total = totals[airlineID[i]];
+            total.issued++;
+            total.paid += paid[i];
+            total.finesIssued += fineAmount[i];
+            total.finesPaid += fineAmount[i] * paid[i];
+        }
+        return totals;
+    }
+};
+
+// AVN Generator class
+class AVNGenerator {
+private:
+    ProfiledMutex<std::mutex> avnMutex;
+    bip::managed_shared_memory segment;
+    SharedAVNVector* avnVector;
+    SharedCounters* sharedCounters;
+    ProfiledMutex<bip::named_mutex> namedMutex;
+
+public:
+    AVNGenerator() : 
+        avnMutex("AVNGenerator::avnMutex"),
+        segment(bip::open_or_create, "AVNSharedMemory", kAVNSegmentSize),
+        namedMutex("AVNMutex", bip::open_or_create, "AVNMutex")
+    {
+        // Initialize shared memory for AVNs
+        ShmemAllocator alloc_inst(segment.get_segment_manager());
+        avnVector = segment.find_or_construct<SharedAVNVector>("AVNVector")(alloc_inst);
+        sharedCounters = segment.find_or_construct<SharedCounters>("Counters")();
+    }
+
+    static double fineAmountFor(AircraftType type) {
+        double baseAmount = 0.0;
+        switch (type) {
             case AircraftType::Commercial:
                 baseAmount = 500000.0;
                 break;
@@ -324,38 +1423,17 @@ public:
         }
         
         // Add 15% service fee
-        double totalAmount = baseAmount * 1.15;
-        
-        int currentAvnId = ++sharedCounters->avnCounter;
-        AVN newAVN(currentAvnId, flight, flight->speed, permissibleSpeed, totalAmount);
-        
-        // Add to shared memory
-        bip::scoped_lock<bip::named_mutex> lock_shared(namedMutex);
-        SharedAVN sharedAVN;
-        sharedAVN.avnID = newAVN.avnID;
-        std::strncpy(sharedAVN.airlineName, newAVN.airlineName.c_str(), 49);
-        sharedAVN.airlineName[49] = '\0';
-        sharedAVN.flightNumber = newAVN.flightNumber;
-        sharedAVN.aircraftType = static_cast<int>(newAVN.aircraftType);
-        sharedAVN.recordedSpeed = newAVN.recordedSpeed;
-        sharedAVN.permissibleSpeed = permissibleSpeed;
-        sharedAVN.issueDateTime = std::chrono::system_clock::to_time_t(newAVN.issueDateTime);
-        sharedAVN.fineAmount = newAVN.fineAmount;
-        sharedAVN.paymentStatus = false;
-        sharedAVN.dueDate = std::chrono::system_clock::to_time_t(newAVN.dueDate);
-        
-        avnVector->push_back(sharedAVN);
-        
-        std::cout << "AVN #" << currentAvnId << " generated for " << flight->airline->name 
-                  << " flight #" << flight->flightNumber << std::endl;
-        std::cout << "  Speed: " << flight->speed << " km/h (limit: " << permissibleSpeed << " km/h)" << std::endl;
-        std::cout << "  Fine Amount: PKR " << totalAmount << " (including 15% service fee)" << std::endl;
-        
-        return currentAvnId;
+        return baseAmount * 1.15;
     }
-    
+
+    // Take the next AVN ID from the shared counter. Used by a controller that
+    // hands the AVN itself to the AVN generator process.
+    int reserveAVNID() {
+        return ++sharedCounters->avnCounter;
+    }
+
     void updatePaymentStatus(int avnID, bool paid) {
-        bip::scoped_lock<bip::named_mutex> lock(namedMutex);
+        ProfiledLock lock(namedMutex);
         
         for (auto& avn : *avnVector) {
             if (avn.avnID == avnID) {
@@ -368,6 +1446,83 @@ public:
         
         std::cout << "AVN #" << avnID << " not found for payment update." << std::endl;
     }
+
+    // Add an AVN whose ID was reserved elsewhere; returns the fine amount
+    double recordAVN(int avnID, const char* airlineName, int flightNumber, AircraftType type,
+                     int flightPhase, ViolationKind kind, float recordedSpeed, float permissibleSpeed,
+                     bool quiet) {
+        auto issued = std::chrono::system_clock::now();
+        SharedAVN sharedAVN{};
+        sharedAVN.avnID = avnID;
+        std::strncpy(sharedAVN.airlineName, airlineName, 49);
+        sharedAVN.airlineName[49] = '\0';
+        sharedAVN.flightNumber = flightNumber;
+        sharedAVN.aircraftType = static_cast<int>(type);
+        sharedAVN.recordedSpeed = recordedSpeed;
+        sharedAVN.permissibleSpeed = permissibleSpeed;
+        sharedAVN.issueDateTime = std::chrono::system_clock::to_time_t(issued);
+        sharedAVN.fineAmount = fineAmountFor(type);
+        sharedAVN.paymentStatus = false;
+        sharedAVN.dueDate = std::chrono::system_clock::to_time_t(issued + std::chrono::hours(24 * 3));
+        sharedAVN.flightPhase = flightPhase;
+        sharedAVN.violationKind = static_cast<int>(kind);
+        {
+            ProfiledLock lock(namedMutex);
+            avnVector->push_back(sharedAVN);
+        }
+
+        if (!quiet) {
+            std::cout << "AVN #" << avnID << " generated for " << sharedAVN.airlineName
+                      << " flight #" << flightNumber << std::endl;
+        }
+        return sharedAVN.fineAmount;
+    }
+
+    // Mark an AVN paid; false if it does not exist or was already paid
+    bool settlePayment(int avnID) {
+        ProfiledLock lock(namedMutex);
+        SharedAVN* avn = findAVN(*avnVector, avnID);
+        if (!avn || avn->paymentStatus) {
+            return false;
+        }
+        avn->paymentStatus = true;
+        return true;
+    }
+
+    // IDs are handed out in order, so an AVN usually sits near index ID - 1
+    static SharedAVN* findAVN(SharedAVNVector& avns, int avnID) {
+        size_t guess = avnID > 0 ? static_cast<size_t>(avnID - 1) : 0;
+        size_t begin = guess > 64 ? guess - 64 : 0;
+        for (size_t i = begin; i < avns.size() && i <= guess + 64; i++) {
+            if (avns[i].avnID == avnID) return &avns[i];
+        }
+        for (auto& avn : avns) {
+            if (avn.avnID == avnID) return &avn;
+        }
+        return nullptr;
+    }
+
+    // Bring a columnar analytics copy up to date with shared memory
+    void syncAnalytics(AVNAnalytics& analytics) {
+        ProfiledLock lock(namedMutex);
+        analytics.refresh(*avnVector);
+    }
+
+    // Copy every AVN and the ID counter out of shared memory
+    std::vector<SharedAVN> snapshotAVNs(int& avnCounter) {
+        ProfiledLock lock(namedMutex);
+        avnCounter = sharedCounters->avnCounter.load();
+        return std::vector<SharedAVN>(avnVector->begin(), avnVector->end());
+    }
+
+    // Replace the shared AVN table with records from a checkpoint
+    void restoreAVNs(const SharedAVN* records, size_t count, int avnCounter) {
+        ProfiledLock lock(namedMutex);
+        avnVector->clear();
+        avnVector->reserve(count);
+        avnVector->insert(avnVector->end(), records, records + count);
+        sharedCounters->avnCounter = avnCounter;
+    }
 };
 
 // AirlinePortal class
@@ -376,13 +1531,13 @@ private:
     std::string airlineName;
     bip::managed_shared_memory segment;
     SharedAVNVector* avnVector;
-    bip::named_mutex namedMutex;
+    ProfiledMutex<bip::named_mutex> namedMutex;
 
 public:
     AirlinePortal(const std::string& name) : 
         airlineName(name),
-        segment(bip::open_or_create, "AVNSharedMemory", 65536),
-        namedMutex(bip::open_or_create, "AVNMutex")
+        segment(bip::open_or_create, "AVNSharedMemory", kAVNSegmentSize),
+        namedMutex("AVNMutex", bip::open_or_create, "AVNMutex")
     {
         avnVector = segment.find<SharedAVNVector>("AVNVector").first;
         if (!avnVector) {
@@ -391,9 +1546,9 @@ public:
     }
     
     void listActiveAVNs() {
-        bip::scoped_lock<bip::named_mutex> lock(namedMutex);
+        ProfiledLock lock(namedMutex);
         {
-            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
+            ProfiledLock consoleLock(g_console_mutex);
             std::cout << "Active AVNs for " << airlineName << ":" << std::endl;
         }
         
@@ -402,7 +1557,7 @@ public:
             for (const auto& avn : *avnVector) {
                 if (strcmp(avn.airlineName, airlineName.c_str()) == 0 && !avn.paymentStatus) {
                     found = true;
-                    std::lock_guard<std::mutex> consoleLock(g_console_mutex);
+                    ProfiledLock consoleLock(g_console_mutex);
                     std::cout << "AVN #" << avn.avnID << ":" << std::endl;
                     std::cout << "  Flight Number: " << avn.flightNumber << std::endl;
                     std::cout << "  Recorded Speed: " << avn.recordedSpeed << " km/h" << std::endl;
@@ -424,25 +1579,107 @@ public:
         }
         
         if (!found) {
-            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
+            ProfiledLock consoleLock(g_console_mutex);
             std::cout << "No active unpaid AVNs found for " << airlineName << std::endl;
         }
     }
     
-    void payAVN(int avnID) {
-        // This would interface with the StripePay process in a real implementation
-        std::cout << "Initiating payment for AVN #" << avnID << "..." << std::endl;
-        
-        // Simulate payment process
-        std::cout << "Processing payment..." << std::endl;
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-        
-        // Update payment status
-        AVNGenerator avnGen;
-        avnGen.updatePaymentStatus(avnID, true);
-        
-        std::cout << "Payment successful for AVN #" << avnID << std::endl;
+    // Fine due on one of this airline's AVNs, or a negative value if none
+    double amountDue(int avnID) {
+        ProfiledLock lock(namedMutex);
+        if (!avnVector) return -1.0;
+        SharedAVN* avn = AVNGenerator::findAVN(*avnVector, avnID);
+        if (!avn || strcmp(avn->airlineName, airlineName.c_str()) != 0) return -1.0;
+        return avn->fineAmount;
+    }
+};
+
+// Payment request and outcome shared by StripePay and the payment queue
+struct PaymentRequest {
+    std::string idempotencyKey;  // Same key, same payment: retries reuse it
+    int avnID;
+    double amount;
+};
+
+enum class PaymentOutcome {
+    Settled,
+    Declined,     // Less than the fine
+    AlreadyPaid,
+    NotFound,
+    KeyReused     // Key already used for a different AVN or amount
+};
+
+struct PaymentResult {
+    std::string idempotencyKey;
+    int avnID;
+    double amount;
+    PaymentOutcome outcome;
+    std::string chargeID;  // Gateway charge, set when the card was charged
+    char airlineName[50];
+    int flightNumber;
+    double fineAmount;
+    bool replayed;         // Result recorded earlier for the same key
+};
+
+// Local stand-in for the card gateway. A charge takes a fixed latency and,
+// like a real gateway's idempotency header, the same key never charges twice.
+class StandInGateway {
+private:
+    struct Charge {
+        std::string chargeID;
+        double amount;
+        bool refunded;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Charge> chargesByKey;
+    std::unordered_map<std::string, std::string> keysByCharge;
+    std::chrono::milliseconds latency;
+    std::atomic<uint64_t> charges;
+    std::atomic<uint64_t> refunds;
+
+public:
+    explicit StandInGateway(std::chrono::milliseconds chargeLatency)
+        : latency(chargeLatency), charges(0), refunds(0) {}
+
+    // Returns the charge ID, or an empty string if the key was already used
+    // for a different amount. The call stands in for the network round trip.
+    std::string charge(const std::string& key, double amount) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = chargesByKey.find(key);
+            if (it != chargesByKey.end()) {
+                return it->second.amount == amount ? it->second.chargeID : std::string();
+            }
+        }
+        std::this_thread::sleep_for(latency);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto [it, inserted] = chargesByKey.try_emplace(key, Charge{"ch_" + std::to_string(charges.load() + 1),
+                                                                   amount, false});
+        if (inserted) {
+            charges++;
+            keysByCharge.emplace(it->second.chargeID, key);
+        } else if (it->second.amount != amount) {
+            return std::string();
+        }
+        return it->second.chargeID;
+    }
+
+    // Refund a charge; false if it is unknown or was already refunded
+    bool refund(const std::string& chargeID) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto key = keysByCharge.find(chargeID);
+        if (key == keysByCharge.end()) return false;
+        Charge& charge = chargesByKey.at(key->second);
+        if (charge.refunded) return false;
+        charge.refunded = true;
+        refunds++;
+        return true;
     }
+
+    uint64_t chargeCount() const { return charges.load(); }
+    uint64_t refundCount() const { return refunds.load(); }
 };
 
 // StripePay class
@@ -450,12 +1687,12 @@ class StripePay {
 private:
     bip::managed_shared_memory segment;
     SharedAVNVector* avnVector;
-    bip::named_mutex namedMutex;
+    ProfiledMutex<bip::named_mutex> namedMutex;
 
 public:
     StripePay() :
-        segment(bip::open_or_create, "AVNSharedMemory", 65536),
-        namedMutex(bip::open_or_create, "AVNMutex")
+        segment(bip::open_or_create, "AVNSharedMemory", kAVNSegmentSize),
+        namedMutex("AVNMutex", bip::open_or_create, "AVNMutex")
     {
         avnVector = segment.find<SharedAVNVector>("AVNVector").first;
         if (!avnVector) {
@@ -463,808 +1700,5919 @@ public:
         }
     }
     
-    bool processPayment(int avnID, double amount) {
-        bip::scoped_lock<bip::named_mutex> lock(namedMutex);
-        
+    // Check a payment against the AVN record without printing a receipt
+    bool authorize(int avnID, double amount) {
+        ProfiledLock lock(namedMutex);
+        if (!avnVector) return false;
+        SharedAVN* avn = AVNGenerator::findAVN(*avnVector, avnID);
+        return avn && !avn->paymentStatus && amount >= avn->fineAmount;
+    }
+    
+    // Charge a payment through the gateway. The AVN table is locked twice,
+    // briefly: once to read the fine and once for the final status flip.
+    // The gateway call in between holds no lock.
+    PaymentResult charge(const PaymentRequest& request, StandInGateway& gateway) {
+        PaymentResult result{};
+        result.idempotencyKey = request.idempotencyKey;
+        result.avnID = request.avnID;
+        result.amount = request.amount;
+
+        SharedAVN avn{};
+        bool found = false;
+        {
+            ProfiledLock lock(namedMutex);
+            if (avnVector) {
+                if (SharedAVN* record = AVNGenerator::findAVN(*avnVector, request.avnID)) {
+                    avn = *record;
+                    found = true;
+                }
+            }
+        }
+        if (!found) {
+            result.outcome = PaymentOutcome::NotFound;
+            return result;
+        }
+        std::snprintf(result.airlineName, sizeof(result.airlineName), "%s", avn.airlineName);
+        result.flightNumber = avn.flightNumber;
+        result.fineAmount = avn.fineAmount;
+        if (avn.paymentStatus) {
+            result.outcome = PaymentOutcome::AlreadyPaid;
+            return result;
+        }
+        if (request.amount < avn.fineAmount) {
+            result.outcome = PaymentOutcome::Declined;
+            return result;
+        }
+
+        result.chargeID = gateway.charge(request.idempotencyKey, request.amount);
+        if (result.chargeID.empty()) {
+            result.outcome = PaymentOutcome::KeyReused;
+            return result;
+        }
+
+        bool settled = false;
+        {
+            ProfiledLock lock(namedMutex);
+            SharedAVN* record = AVNGenerator::findAVN(*avnVector, request.avnID);
+            if (record && !record->paymentStatus) {
+                record->paymentStatus = true;
+                settled = true;
+            }
+        }
+        if (!settled) {
+            // Paid under another key while this charge was in flight
+            gateway.refund(result.chargeID);
+            result.outcome = PaymentOutcome::AlreadyPaid;
+            return result;
+        }
+        result.outcome = PaymentOutcome::Settled;
+        return result;
+    }
+
+    static void printReceipt(const PaymentResult& result) {
+        ProfiledLock consoleLock(g_console_mutex);
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
         std::cout << "\n╔════════════════════════════════════════╗\n";
         std::cout << "║          PAYMENT PROCESSING            ║\n";
         std::cout << "╠════════════════════════════════════════╣\n";
-        
-        for (const auto& avn : *avnVector) {
-            if (avn.avnID == avnID) {
-                std::cout << "║ AVN ID: #" << std::setw(4) << avn.avnID << "\n";
-                std::cout << "║ Airline: " << avn.airlineName << "\n";
-                std::cout << "║ Flight: #" << avn.flightNumber << "\n";
-                std::cout << "║ Amount Due: PKR " << std::fixed << std::setprecision(2) 
-                          << avn.fineAmount << "\n";
-                std::cout << "║ Amount Paid: PKR " << amount << "\n";
-                
-                if (amount >= avn.fineAmount) {
-                    if (amount > avn.fineAmount) {
-                        std::cout << "║ Change: PKR " << (amount - avn.fineAmount) << "\n";
-                    }
-                    std::cout << "╟────────────────────────────────────────╢\n";
-                    std::cout << "║          PAYMENT SUCCESSFUL            ║\n";
-                    
-                    AVNGenerator avnGen;
-                    avnGen.updatePaymentStatus(avnID, true);
-                    
-                    std::cout << "╚════════════════════════════════════════╝\n";
-                    return true;
-                } else {
-                    std::cout << "╟────────────────────────────────────────╢\n";
-                    std::cout << "║          PAYMENT FAILED                ║\n";
-                    std::cout << "║ Reason: Insufficient payment           ║\n";
-                    std::cout << "║ Missing: PKR " << (avn.fineAmount - amount) << "\n";
-                    std::cout << "╚════════════════════════════════════════╝\n";
-                    return false;
-                }
-            }
+        std::cout << "║ AVN ID: #" << std::setw(4) << result.avnID << "\n";
+        if (result.outcome != PaymentOutcome::NotFound) {
+            std::cout << "║ Airline: " << result.airlineName << "\n";
+            std::cout << "║ Flight: #" << result.flightNumber << "\n";
+            std::cout << "║ Amount Due: PKR " << std::fixed << std::setprecision(2) << result.fineAmount << "\n";
+            std::cout << "║ Amount Paid: PKR " << result.amount << "\n";
         }
-        
+        std::cout << "║ Idempotency Key: " << result.idempotencyKey << (result.replayed ? " (replayed)" : "") << "\n";
         std::cout << "╟────────────────────────────────────────╢\n";
-        std::cout << "║          PAYMENT FAILED                ║\n";
-        std::cout << "║ Reason: AVN #" << avnID << " not found          ║\n";
+        switch (result.outcome) {
+            case PaymentOutcome::Settled:
+                if (result.amount > result.fineAmount) {
+                    std::cout << "║ Change: PKR " << (result.amount - result.fineAmount) << "\n";
+                }
+                std::cout << "║ Charge: " << result.chargeID << "\n";
+                std::cout << "║          PAYMENT SUCCESSFUL            ║\n";
+                break;
+            case PaymentOutcome::Declined:
+                std::cout << "║          PAYMENT FAILED                ║\n";
+                std::cout << "║ Reason: Insufficient payment           ║\n";
+                std::cout << "║ Missing: PKR " << (result.fineAmount - result.amount) << "\n";
+                break;
+            case PaymentOutcome::AlreadyPaid:
+                std::cout << "║          PAYMENT FAILED                ║\n";
+                std::cout << "║ Reason: AVN already paid               ║\n";
+                break;
+            case PaymentOutcome::NotFound:
+                std::cout << "║          PAYMENT FAILED                ║\n";
+                std::cout << "║ Reason: AVN #" << result.avnID << " not found          ║\n";
+                break;
+            case PaymentOutcome::KeyReused:
+                std::cout << "║          PAYMENT FAILED                ║\n";
+                std::cout << "║ Reason: Key used for another amount    ║\n";
+                break;
+        }
         std::cout << "╚════════════════════════════════════════╝\n";
-        return false;
+        std::cout.flags(flags);
+        std::cout.precision(precision);
     }
 };
 
-// ATCS Controller class
-class ATCSController {
-private:
-    std::vector<Airline> airlines;
-    std::vector<std::unique_ptr<Runway>> runways;
-    std::vector<std::unique_ptr<Flight>> flights;  // Changed to unique_ptr
-    std::vector<AVN> avns;
-    std::unique_ptr<AVNGenerator> avnGenerator;
+// Asynchronous payments. Requests wait in a queue for a pool of workers,
+// so callers never block on the gateway; each caller is notified through
+// its callback when the payment completes. Requests are deduplicated by
+// idempotency key: a retry while the first attempt is in flight waits for
+// it, and a retry afterwards gets the recorded result, so nothing is
+// charged twice. A key reused for a different AVN or amount is refused.
+class PaymentQueue {
+public:
+    using Callback = std::function<void(const PaymentResult&)>;
 
-    std::mutex flightsMutex;
-    std::mutex avnMutex;
-    std::atomic<bool> simulationRunning;
-    std::chrono::steady_clock::time_point simulationStartTime;
-    std::chrono::seconds simulationDuration;
+    enum class Submitted {
+        Queued,     // New key, charge queued
+        Duplicate,  // Same request as before: attached or replayed
+        KeyReused   // Key already used for a different AVN or amount
+    };
 
-    // Flight scheduling system
-    struct FlightSchedule {
-        FlightDirection direction;
-        int intervalSeconds;
-        float emergencyProbability;
-        std::string description;
-        EmergencyType emergencyType;
+private:
+    struct KeyState {
+        PaymentRequest request;
+        bool done = false;
+        PaymentResult result{};
+        std::vector<Callback> waiters;
     };
 
-    std::vector<FlightSchedule> flightSchedules;
-    std::atomic<bool> flightGenerationRunning;
+    StandInGateway gateway;
+    StripePay stripePay;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable idle;
+    std::deque<PaymentRequest> pending;
+    std::unordered_map<std::string, KeyState> keys;
+    std::vector<std::thread> workers;
+    size_t inFlight;
+    bool stopping;
 
-    // Priority queue for runway allocation
-    struct FlightPriorityComparator {
-        bool operator()(const Flight* a, const Flight* b) {
-            // First compare by priority level (lower number = higher priority)
-            if (a->priorityLevel != b->priorityLevel)
-                return a->priorityLevel > b->priorityLevel;
-            
-            // If same priority, compare by scheduled time (earlier = higher priority)
-            return a->scheduledTime > b->scheduledTime;
-        }
-    };
+    void workerLoop() {
+        g_tracer.nameThread("payment-worker");
+        AllocTracker::tagThread(AllocSubsystem::Payments);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            workAvailable.wait(lock, [this] { return !pending.empty() || stopping; });
+            if (pending.empty()) return;
 
-    std::priority_queue<Flight*, std::vector<Flight*>, FlightPriorityComparator> runwayQueue;
+            PaymentRequest request = std::move(pending.front());
+            pending.pop_front();
+            inFlight++;
+            lock.unlock();
 
-    bip::managed_shared_memory segment;
-    SharedRunwayStatus* sharedRunwayStatus;
+            PaymentResult result = stripePay.charge(request, gateway);
+
+            lock.lock();
+            KeyState& state = keys[request.idempotencyKey];
+            state.done = true;
+            state.result = result;
+            std::vector<Callback> waiters = std::move(state.waiters);
+            state.waiters.clear();
+            lock.unlock();
+
+            for (size_t i = 0; i < waiters.size(); i++) {
+                PaymentResult notified = result;
+                notified.replayed = i > 0;
+                if (waiters[i]) waiters[i](notified);
+            }
+
+            lock.lock();
+            inFlight--;
+            if (pending.empty() && inFlight == 0) {
+                idle.notify_all();
+            }
+        }
+    }
 
 public:
-    ATCSController() : 
-        simulationRunning(false), 
-        flightGenerationRunning(false),
-        simulationDuration(std::chrono::seconds(300)), // 5 minutes
-        segment(bip::open_or_create, "ATCSSharedMemory", 65536)
+    PaymentQueue(int workerCount, std::chrono::milliseconds gatewayLatency)
+        : gateway(gatewayLatency), inFlight(0), stopping(false)
     {
-        // Clean up old shared memory at startup
-        bip::shared_memory_object::remove("ATCSSharedMemory");
-        bip::shared_memory_object::remove("AVNSharedMemory");
-        bip::named_mutex::remove("AVNMutex");
-        
-        // Initialize shared memory
-        segment = bip::managed_shared_memory(bip::create_only, "ATCSSharedMemory", 65536);
-        sharedRunwayStatus = segment.construct<SharedRunwayStatus>("RunwayStatus")();
-
-        // Initialize airlines
-        airlines.emplace_back("PIA", AircraftType::Commercial, 6, 4);
-        airlines.emplace_back("AirBlue", AircraftType::Commercial, 4, 4);
-        airlines.emplace_back("FedEx Cargo", AircraftType::Cargo, 3, 2);
-        airlines.emplace_back("Pakistan Airforce", AircraftType::Emergency, 2, 1);
-        airlines.emplace_back("Blue Dart Cargo", AircraftType::Cargo, 2, 2);
-        airlines.emplace_back("AghaKhan Air Ambulance", AircraftType::Emergency, 2, 1);
+        for (int i = 0; i < std::max(1, workerCount); i++) {
+            workers.emplace_back(&PaymentQueue::workerLoop, this);
+        }
+    }
 
-        // Initialize runways
-        runways.push_back(std::make_unique<Runway>(0, "RWY-A (North-South Arrivals)"));
-        runways.push_back(std::make_unique<Runway>(1, "RWY-B (East-West Departures)"));
-        runways.push_back(std::make_unique<Runway>(2, "RWY-C (Cargo/Emergency/Overflow)"));
+    ~PaymentQueue() {
+        shutdown();
+    }
 
-        // Initialize flight schedules with specific emergency types
-        flightSchedules = {
-            {FlightDirection::NorthArrival, 180, 0.10f, "International Arrivals", EmergencyType::DiversionOrLowFuel},
-            {FlightDirection::SouthArrival, 120, 0.05f, "Domestic Arrivals", EmergencyType::Medical},
-            {FlightDirection::EastDeparture, 150, 0.15f, "International Departures", EmergencyType::Military},
-            {FlightDirection::WestDeparture, 240, 0.20f, "Domestic Departures", EmergencyType::VIP}
-        };
+    // Queue a payment; onComplete runs on a payment worker. Only a Queued
+    // request makes a new charge. A reused key gets a KeyReused result at
+    // once, on the calling thread, and leaves the first request untouched.
+    Submitted submit(const PaymentRequest& request, Callback onComplete) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto [it, inserted] = keys.try_emplace(request.idempotencyKey);
+        KeyState& state = it->second;
+        if (!inserted) {
+            if (state.request.avnID != request.avnID || state.request.amount != request.amount) {
+                lock.unlock();
+                PaymentResult refused{};
+                refused.idempotencyKey = request.idempotencyKey;
+                refused.avnID = request.avnID;
+                refused.amount = request.amount;
+                refused.outcome = PaymentOutcome::KeyReused;
+                if (onComplete) onComplete(refused);
+                return Submitted::KeyReused;
+            }
+            if (!state.done) {
+                state.waiters.push_back(std::move(onComplete));
+                return Submitted::Duplicate;
+            }
+            PaymentResult replay = state.result;
+            replay.replayed = true;
+            lock.unlock();
+            if (onComplete) onComplete(replay);
+            return Submitted::Duplicate;
+        }
+        state.request = request;
+        state.waiters.push_back(std::move(onComplete));
+        pending.push_back(request);
+        lock.unlock();
+        workAvailable.notify_one();
+        return Submitted::Queued;
+    }
 
-        // Initialize AVN Generator
-        avnGenerator = std::make_unique<AVNGenerator>();
+    // Block until every queued payment has completed
+    void drain() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return pending.empty() && inFlight == 0; });
     }
 
-    // Add flight to system
-    void addFlight(std::unique_ptr<Flight> flight) {
-        std::lock_guard<std::mutex> lock(flightsMutex);
-        Flight* flightPtr = flight.get();
-        runwayQueue.push(flightPtr);
-        
+    // Finish queued payments, then stop the workers
+    void shutdown() {
         {
-            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-            std::cout << "\n=== NEW FLIGHT ADDED ===\n";
-            std::cout << "Flight: #" << flight->flightNumber 
-                      << " (" << flight->airline->name << ")\n";
-            std::cout << "Type: " << flight->getAircraftTypeString() << "\n";
-            std::cout << "Direction: " << flight->getDirectionString() << "\n";
-            std::cout << "============================\n";
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
         }
-                  
-        flights.push_back(std::move(flight));
+        workAvailable.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+        workers.clear();
     }
 
-    // Thread function to manage flight lifecycle
-    void flightThread(Flight& flight) {
-        using namespace std::chrono;
-        steady_clock::time_point phaseStart = steady_clock::now();
-        
-        while (simulationRunning) {
-            std::this_thread::sleep_for(milliseconds(100));
-            steady_clock::time_point now = steady_clock::now();
-            auto elapsed = duration_cast<seconds>(now - phaseStart).count();
+    // Outcome recorded for a key; false if the key was never submitted.
+    // done stays false while the payment is still queued or in flight.
+    bool lookup(const std::string& key, PaymentResult& result, bool& done) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = keys.find(key);
+        if (it == keys.end()) return false;
+        done = it->second.done;
+        if (done) result = it->second.result;
+        return true;
+    }
 
-            // Manage flight phases with timing
-            switch (flight.phase) {
-                case FlightPhase::Holding:
-                    if (elapsed >= 10) {
-                        flight.updatePhase(FlightPhase::Approach);
-                        flight.updateSpeed(400 + rand() % 201); // 400-600 km/h
-                        phaseStart = now;
-                        
-                        {
-                            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                            std::cout << "\n=== PHASE TRANSITION ===\n";
-                            std::cout << "Flight: #" << flight.flightNumber << "\n";
-                            std::cout << "New Phase: " << flight.getPhaseString() << "\n";
-                            std::cout << "Speed: " << flight.speed << " km/h\n";
-                            std::cout << "============================\n";
-                        }
-                        checkSpeedViolation(flight);
-                    }
-                    break;
-                    
-                case FlightPhase::Approach:
-                    if (elapsed >= 8) {
-                        flight.updatePhase(FlightPhase::Landing);
-                        flight.updateSpeed(240); // Start at max allowed landing speed
-                        phaseStart = now;
-                        
-                        {
-                            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                            std::cout << "\n=== PHASE TRANSITION ===\n";
-                            std::cout << "Flight: #" << flight.flightNumber << "\n";
-                            std::cout << "New Phase: " << flight.getPhaseString() << "\n";
-                            std::cout << "Speed: " << flight.speed << " km/h\n";
-                            std::cout << "============================\n";
-                        }
-                        checkSpeedViolation(flight);
-                    }
-                    break;
-                    
-                case FlightPhase::Landing:
-                    // Gradually decrease speed during landing
-                    if (elapsed < 6) {
-                        float landingProgress = elapsed / 6.0f; // 0 to 1
-                        float newSpeed = 240.0f * (1.0f - landingProgress) + 30.0f * landingProgress;
-                        flight.updateSpeed(newSpeed);
-                        checkSpeedViolation(flight);
-                    } else {
-                        flight.updatePhase(FlightPhase::Taxi);
-                        flight.updateSpeed(20); // Safe taxi speed
-                        phaseStart = now;
-                        
-                        {
-                            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                            std::cout << "\n=== PHASE TRANSITION ===\n";
-                            std::cout << "Flight: #" << flight.flightNumber << "\n";
-                            std::cout << "New Phase: " << flight.getPhaseString() << "\n";
-                            std::cout << "Speed: " << flight.speed << " km/h\n";
-                            std::cout << "============================\n";
-                        }
-                    }
-                    break;
-                    
-                case FlightPhase::Taxi:
-                    if (elapsed >= 5) {
-                        flight.updatePhase(FlightPhase::AtGate);
-                        flight.updateSpeed(0.0f);
-                        phaseStart = now;
-                        
-                        {
-                            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                            std::cout << "\n=== PHASE TRANSITION ===\n";
-                            std::cout << "Flight: #" << flight.flightNumber << "\n";
-                            std::cout << "New Phase: " << flight.getPhaseString() << "\n";
-                            std::cout << "============================\n";
-                        }
-                    }
-                    break;
-                case FlightPhase::AtGate:
-                    if (elapsed >= 5) {
-                        if (flight.direction == FlightDirection::EastDeparture || 
-                            flight.direction == FlightDirection::WestDeparture) {
-                            flight.updatePhase(FlightPhase::Taxi);
-                            flight.updateSpeed(15 + rand() % 16); // 15-30 km/h for taxiing
-                            phaseStart = now;
-                            
-                            {
-                                std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                                std::cout << "\n=== PHASE TRANSITION ===\n";
-                                std::cout << "Flight: #" << flight.flightNumber << "\n";
-                                std::cout << "New Phase: " << flight.getPhaseString() << "\n";
-                                std::cout << "Speed: " << flight.speed << " km/h\n";
-                                std::cout << "============================\n";
-                            }
+    size_t workerCount() const { return workers.size(); }
+    uint64_t gatewayCharges() const { return gateway.chargeCount(); }
+    uint64_t gatewayRefunds() const { return gateway.refundCount(); }
+};
+
+// Multi-process mode. The controller, AVN generator, airline portal and
+// StripePay run as separate processes, each reading typed messages from its
+// own message queue:
+//   controller --Violation--> AVN --AVNIssued--> portal(s)
+//   portal --PaymentRequest--> StripePay --PaymentResult--> AVN payments inbox
+//   AVN --PaymentSettled--> controller
+// The payment result has its own AVN inbox so a full queue can never close a
+// cycle. AVN IDs are reserved by the controller from the shared counter, so
+// flights keep their IDs without waiting for a reply.
+enum class IpcMessageType : uint8_t {
+    Violation = 1,
+    AVNIssued,
+    PaymentRequest,
+    PaymentResult,
+    PaymentSettled,
+    Shutdown
+};
+
+// Monotonic timestamps carried through the pipeline, one per stage
+enum IpcStage {
+    kIpcViolationSent,
+    kIpcAVNIssued,
+    kIpcPaymentRequested,
+    kIpcPaymentResult,
+    kIpcStageCount
+};
+
+const uint8_t kIpcProtocolVersion = 1;
+const size_t kIpcQueueDepth = 4096;
+const size_t kIpcSpillLimit = 16384;  // Violations held in the controller while the AVN inbox is full
+const std::chrono::milliseconds kIpcShutdownTimeout(5000);
+
+const char* const kIpcControllerInbox = "ATCS.Controller";
+const char* const kIpcAVNInbox = "ATCS.AVN";
+const char* const kIpcAVNPaymentsInbox = "ATCS.AVNPayments";
+const char* const kIpcPortalInbox = "ATCS.Portal";
+const char* const kIpcStripePayInbox = "ATCS.StripePay";
+
+// Fixed-size message; the type says which fields are meaningful
+struct IpcMessage {
+    uint8_t type;
+    uint8_t version;
+    uint8_t success;       // PaymentResult, PaymentSettled
+    uint8_t aircraftType;  // Violation
+    int32_t avnID;
+    int32_t flightNumber;
+    int32_t flightPhase;   // Violation
+    int32_t violationKind; // Violation
+    float recordedSpeed;   // Violation
+    float permissibleSpeed;
+    double amount;         // AVNIssued: fine, PaymentRequest: amount paid
+    int64_t stampNs[kIpcStageCount];
+    char airlineName[50];
+};
+
+inline int64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline IpcMessage makeIpcMessage(IpcMessageType type) {
+    IpcMessage message{};
+    message.type = static_cast<uint8_t>(type);
+    message.version = kIpcProtocolVersion;
+    return message;
+}
+
+// One process's end of a named queue
+class IpcQueue {
+private:
+    bip::message_queue queue;
+
+public:
+    explicit IpcQueue(const char* name) : queue(bip::open_only, name) {}
+
+    static void createAll() {
+        removeAll();
+        for (const char* name : {kIpcControllerInbox, kIpcAVNInbox, kIpcAVNPaymentsInbox,
+                                 kIpcPortalInbox, kIpcStripePayInbox}) {
+            bip::message_queue(bip::create_only, name, kIpcQueueDepth, sizeof(IpcMessage));
+        }
+    }
+
+    static void removeAll() {
+        for (const char* name : {kIpcControllerInbox, kIpcAVNInbox, kIpcAVNPaymentsInbox,
+                                 kIpcPortalInbox, kIpcStripePayInbox}) {
+            bip::message_queue::remove(name);
+        }
+    }
+
+    // Blocks while the queue is full, which is the pipeline's backpressure
+    void send(const IpcMessage& message) {
+        queue.send(&message, sizeof(message), 0);
+    }
+
+    // False if the queue stayed full for the whole timeout; zero never waits
+    bool trySend(const IpcMessage& message, std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        if (timeout.count() <= 0) {
+            return queue.try_send(&message, sizeof(message), 0);
+        }
+        auto deadline = boost::posix_time::microsec_clock::universal_time() +
+                        boost::posix_time::milliseconds(timeout.count());
+        return queue.timed_send(&message, sizeof(message), 0, deadline);
+    }
+
+    // False on timeout. Messages from another protocol version are dropped.
+    bool receive(IpcMessage& message, std::chrono::milliseconds timeout) {
+        bip::message_queue::size_type received = 0;
+        unsigned int priority = 0;
+        auto deadline = boost::posix_time::microsec_clock::universal_time() +
+                        boost::posix_time::milliseconds(timeout.count());
+        while (queue.timed_receive(&message, sizeof(message), received, priority, deadline)) {
+            if (received == sizeof(message) && message.version == kIpcProtocolVersion) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Child processes exit on their own if the controller goes away
+inline bool ipcParentAlive(pid_t parent) {
+    return getppid() == parent;
+}
+
+// AVN generator process: records AVNs for violations and settles payments
+int runAVNProcess(int portals, bool quiet) {
+    pid_t parent = getppid();
+    pinCurrentThread(g_lowLatency.workerCore, "AVN generator");  // Inherited by the payments thread
+    AVNGenerator generator;
+    IpcQueue inbox(kIpcAVNInbox);
+    IpcQueue paymentsInbox(kIpcAVNPaymentsInbox);
+    IpcQueue portalQueue(kIpcPortalInbox);
+    IpcQueue controllerQueue(kIpcControllerInbox);
+    uint64_t issued = 0;
+    uint64_t settled = 0;
+
+    std::thread payments([&]() {
+        IpcMessage message;
+        while (ipcParentAlive(parent)) {
+            if (!paymentsInbox.receive(message, std::chrono::milliseconds(200))) continue;
+            if (message.type == static_cast<uint8_t>(IpcMessageType::Shutdown)) {
+                controllerQueue.send(message);
+                break;
+            }
+            if (message.type != static_cast<uint8_t>(IpcMessageType::PaymentResult)) continue;
+
+            message.type = static_cast<uint8_t>(IpcMessageType::PaymentSettled);
+            message.success = message.success && generator.settlePayment(message.avnID);
+            if (message.success) settled++;
+            controllerQueue.send(message);
+        }
+    });
+
+    IpcMessage message;
+    while (ipcParentAlive(parent)) {
+        if (!inbox.receive(message, std::chrono::milliseconds(200))) continue;
+        if (message.type == static_cast<uint8_t>(IpcMessageType::Shutdown)) {
+            // One shutdown per portal; queued AVNs are ahead of them
+            for (int i = 0; i < portals; i++) {
+                portalQueue.send(message);
+            }
+            break;
+        }
+        if (message.type != static_cast<uint8_t>(IpcMessageType::Violation)) continue;
+
+        message.amount = generator.recordAVN(message.avnID, message.airlineName, message.flightNumber,
+                                             static_cast<AircraftType>(message.aircraftType),
+                                             message.flightPhase,
+                                             static_cast<ViolationKind>(message.violationKind),
+                                             message.recordedSpeed, message.permissibleSpeed, quiet);
+        message.type = static_cast<uint8_t>(IpcMessageType::AVNIssued);
+        message.stampNs[kIpcAVNIssued] = monotonicNs();
+        portalQueue.send(message);
+        issued++;
+    }
+
+    payments.join();
+    if (!quiet) {
+        std::cout << "AVN generator process: " << issued << " AVNs issued, "
+                  << settled << " payments settled" << std::endl;
+    }
+    return 0;
+}
+
+// Airline portal process: pays each AVN in full as soon as it is issued.
+// Several portal processes can share the portal inbox.
+int runPortalProcess(bool quiet) {
+    pid_t parent = getppid();
+    IpcQueue inbox(kIpcPortalInbox);
+    IpcQueue stripePayQueue(kIpcStripePayInbox);
+    uint64_t requested = 0;
+
+    IpcMessage message;
+    while (ipcParentAlive(parent)) {
+        if (!inbox.receive(message, std::chrono::milliseconds(200))) continue;
+        if (message.type == static_cast<uint8_t>(IpcMessageType::Shutdown)) {
+            stripePayQueue.send(message);
+            break;
+        }
+        if (message.type != static_cast<uint8_t>(IpcMessageType::AVNIssued)) continue;
+
+        message.type = static_cast<uint8_t>(IpcMessageType::PaymentRequest);
+        message.stampNs[kIpcPaymentRequested] = monotonicNs();
+        stripePayQueue.send(message);
+        requested++;
+    }
+
+    if (!quiet) {
+        std::cout << "Airline portal process " << getpid() << ": "
+                  << requested << " payments requested" << std::endl;
+    }
+    return 0;
+}
+
+// StripePay process: authorizes payments against the shared AVN table
+int runStripePayProcess(int portals, bool quiet) {
+    pid_t parent = getppid();
+    StripePay stripePay;
+    IpcQueue inbox(kIpcStripePayInbox);
+    IpcQueue avnPaymentsQueue(kIpcAVNPaymentsInbox);
+    uint64_t approved = 0;
+    uint64_t declined = 0;
+    int shutdowns = 0;
+
+    IpcMessage message;
+    while (ipcParentAlive(parent)) {
+        if (!inbox.receive(message, std::chrono::milliseconds(200))) continue;
+        if (message.type == static_cast<uint8_t>(IpcMessageType::Shutdown)) {
+            // Every portal's requests are queued ahead of its own shutdown
+            if (++shutdowns < portals) continue;
+            avnPaymentsQueue.send(message);
+            break;
+        }
+        if (message.type != static_cast<uint8_t>(IpcMessageType::PaymentRequest)) continue;
+
+        message.type = static_cast<uint8_t>(IpcMessageType::PaymentResult);
+        message.success = stripePay.authorize(message.avnID, message.amount) ? 1 : 0;
+        message.stampNs[kIpcPaymentResult] = monotonicNs();
+        avnPaymentsQueue.send(message);
+        if (message.success) approved++; else declined++;
+    }
+
+    if (!quiet) {
+        std::cout << "StripePay process: " << approved << " approved, "
+                  << declined << " declined" << std::endl;
+    }
+    return 0;
+}
+
+// Pay `count` fresh AVNs through the payment queue, submitting every payment
+// twice under the same key to show that retries never charge again.
+int runPaymentBenchmark(uint64_t count, int workers, std::chrono::milliseconds gatewayLatency) {
+    AVNGenerator generator;
+    int firstID = 1000000;
+    for (uint64_t i = 0; i < count; i++) {
+        generator.recordAVN(firstID + static_cast<int>(i), "PIA", 1000 + static_cast<int>(i % 1000),
+                            AircraftType::Commercial, 0, ViolationKind::Speed, 650.0f, 600.0f, true);
+    }
+
+    std::mutex resultsMutex;
+    std::vector<int64_t> latencyNs;
+    uint64_t settled = 0;
+    uint64_t replayed = 0;
+    uint64_t failed = 0;
+    latencyNs.reserve(count);
+
+    PaymentQueue queue(workers, gatewayLatency);
+    int64_t started = monotonicNs();
+    for (uint64_t i = 0; i < count; i++) {
+        PaymentRequest request{"bench-" + std::to_string(firstID + i), firstID + static_cast<int>(i),
+                               AVNGenerator::fineAmountFor(AircraftType::Commercial)};
+        int64_t submitted = monotonicNs();
+        auto onComplete = [&, submitted](const PaymentResult& result) {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            if (result.replayed) {
+                replayed++;
+            } else if (result.outcome == PaymentOutcome::Settled) {
+                settled++;
+                latencyNs.push_back(monotonicNs() - submitted);
+            } else {
+                failed++;
+            }
+        };
+        queue.submit(request, onComplete);
+        queue.submit(request, onComplete);  // Client retry
+    }
+    queue.drain();
+    double wallSeconds = (monotonicNs() - started) / 1e9;
+
+    std::sort(latencyNs.begin(), latencyNs.end());
+    auto percentileMs = [&latencyNs](double p) {
+        if (latencyNs.empty()) return 0.0;
+        size_t index = std::min(latencyNs.size() - 1, static_cast<size_t>(p * (latencyNs.size() - 1) + 0.5));
+        return latencyNs[index] / 1e6;
+    };
+
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "\n=== PAYMENT QUEUE BENCHMARK ===\n";
+    std::cout << "Workers: " << queue.workerCount()
+              << " | Gateway latency: " << gatewayLatency.count() << " ms\n";
+    std::cout << "Payments: " << count << " submitted twice | Settled: " << settled
+              << " | Replayed retries: " << replayed << " | Failed: " << failed << "\n";
+    std::cout << "Gateway charges: " << queue.gatewayCharges()
+              << " | Refunds: " << queue.gatewayRefunds() << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Throughput: " << (wallSeconds > 0 ? settled / wallSeconds : 0.0) << " payments/s over "
+              << std::setprecision(2) << wallSeconds << " s\n";
+    std::cout << "Latency p50/p99: " << percentileMs(0.50) << " / " << percentileMs(0.99) << " ms\n";
+    std::cout << "============================\n";
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+    return queue.gatewayCharges() == count ? 0 : 1;
+}
+
+// Controller end of the multi-process pipeline. Spawns the other processes,
+// forwards violations and collects per-stage latency from settlements.
+class IpcPipeline {
+private:
+    std::unique_ptr<IpcQueue> avnQueue;
+    std::unique_ptr<IpcQueue> inbox;
+    pid_t avnPid;
+    std::atomic<bool> avnReaped;  // Set if the AVN process exited without a shutdown
+    std::vector<pid_t> children;
+    int portals;
+    std::thread settlementThread;
+    std::atomic<uint64_t> submitted;
+
+    // Lifecycle workers never wait on the AVN inbox. Violations that find it
+    // full wait here, in order, and the settlement thread forwards them.
+    std::mutex spillMutex;
+    std::deque<IpcMessage> spill;
+    std::atomic<uint64_t> spilled;
+    std::atomic<uint64_t> dropped;  // Spill full, or the AVN process is gone
+    std::atomic<int64_t> shutdownDeadlineNs;
+
+    // Written by the settlement thread, read after it has been joined
+    std::vector<int64_t> stageLatencyNs[kIpcStageCount];  // Last entry is end to end
+    uint64_t settled;
+    uint64_t declined;
+    int64_t firstSubmitNs;
+    int64_t lastSettleNs;
+
+    pid_t spawn(const std::vector<std::string>& args) {
+        std::cout.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            std::vector<char*> argv;
+            for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+            argv.push_back(nullptr);
+            execv("/proc/self/exe", argv.data());
+            _exit(127);
+        }
+        if (pid > 0) children.push_back(pid);
+        return pid;
+    }
+
+    // Forward spilled violations until the inbox fills again. Returns
+    // whether the spill is empty.
+    bool flushSpill(std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        std::lock_guard<std::mutex> lock(spillMutex);
+        if (avnReaped) {
+            dropped += spill.size();
+            spill.clear();
+        }
+        while (!spill.empty() && avnQueue->trySend(spill.front(), timeout)) {
+            spill.pop_front();
+        }
+        return spill.empty();
+    }
+
+    void collectSettlements() {
+        pinCurrentThread(g_lowLatency.workerCore, "IPC settlement");
+        AllocTracker::tagThread(AllocSubsystem::Ipc);
+        IpcMessage message;
+        while (true) {
+            bool spillEmpty = flushSpill();
+            int64_t deadline = shutdownDeadlineNs.load();
+            if (deadline != 0 && monotonicNs() > deadline) break;
+            if (!inbox->receive(message, std::chrono::milliseconds(spillEmpty ? 200 : 10))) {
+                int status = 0;
+                if (waitpid(avnPid, &status, WNOHANG) == avnPid) {
+                    avnReaped = true;
+                    flushSpill();
+                    break;
+                }
+                continue;
+            }
+            if (message.type == static_cast<uint8_t>(IpcMessageType::Shutdown)) break;
+            if (message.type != static_cast<uint8_t>(IpcMessageType::PaymentSettled)) continue;
+
+            int64_t now = monotonicNs();
+            if (!message.success) {
+                declined++;
+                continue;
+            }
+            settled++;
+            lastSettleNs = now;
+            for (int stage = 0; stage + 1 < kIpcStageCount; stage++) {
+                stageLatencyNs[stage].push_back(message.stampNs[stage + 1] - message.stampNs[stage]);
+            }
+            stageLatencyNs[kIpcStageCount - 1].push_back(now - message.stampNs[kIpcViolationSent]);
+        }
+    }
+
+    static double percentileMs(const std::vector<int64_t>& sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+        return sorted[index] / 1e6;
+    }
+
+public:
+    // Queues must be created and the AVN segment must exist before this runs
+    IpcPipeline(int portalCount, bool quiet)
+        : avnPid(-1), avnReaped(false), portals(std::max(portalCount, 1)), submitted(0),
+          spilled(0), dropped(0), shutdownDeadlineNs(0), settled(0), declined(0), firstSubmitNs(0), lastSettleNs(0)
+    {
+        IpcQueue::createAll();
+        avnQueue = std::make_unique<IpcQueue>(kIpcAVNInbox);
+        inbox = std::make_unique<IpcQueue>(kIpcControllerInbox);
+
+        std::string portalArg = std::to_string(portals);
+        std::vector<std::string> common = {"--portals", portalArg};
+        if (quiet) common.push_back("--quiet");
+        if (g_lowLatency.workerCore >= 0) {
+            common.push_back("--pin-workers");
+            common.push_back(std::to_string(g_lowLatency.workerCore));
+        }
+        auto roleArgs = [&](const char* role) {
+            std::vector<std::string> args = {"atcs_simulation", "--role", role};
+            args.insert(args.end(), common.begin(), common.end());
+            return args;
+        };
+
+        avnPid = spawn(roleArgs("avn"));
+        for (int i = 0; i < portals; i++) {
+            spawn(roleArgs("portal"));
+        }
+        spawn(roleArgs("stripepay"));
+
+        settlementThread = std::thread(&IpcPipeline::collectSettlements, this);
+    }
+
+    ~IpcPipeline() {
+        shutdown();
+    }
+
+    // False if the violation was dropped (spill full or the AVN process is
+    // gone); the AVN will then never be recorded
+    bool submitViolation(const Flight& flight, float permissibleSpeed, ViolationKind kind, int avnID) {
+        IpcMessage message = makeIpcMessage(IpcMessageType::Violation);
+        message.avnID = avnID;
+        message.flightNumber = flight.flightNumber;
+        message.aircraftType = static_cast<uint8_t>(flight.aircraftType);
+        message.flightPhase = static_cast<int32_t>(flight.phase.load());
+        message.violationKind = static_cast<int32_t>(kind);
+        message.recordedSpeed = flight.speed;
+        message.permissibleSpeed = permissibleSpeed;
+        std::strncpy(message.airlineName, flight.airline->name.c_str(), sizeof(message.airlineName) - 1);
+        message.stampNs[kIpcViolationSent] = monotonicNs();
+        if (submitted++ == 0) {
+            firstSubmitNs = message.stampNs[kIpcViolationSent];
+        }
+        if (avnReaped) {
+            dropped++;
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(spillMutex);
+        if (spill.empty() && avnQueue->trySend(message)) return true;
+        if (spill.size() >= kIpcSpillLimit) {
+            dropped++;
+            return false;
+        }
+        spill.push_back(message);
+        spilled++;
+        return true;
+    }
+
+    // Drain the pipeline, then reap the child processes. Gives up after
+    // kIpcShutdownTimeout and kills whatever is still running.
+    void shutdown() {
+        if (children.empty()) return;
+        int64_t deadline = monotonicNs() +
+            std::chrono::duration_cast<std::chrono::nanoseconds>(kIpcShutdownTimeout).count();
+        auto remaining = [deadline]() {
+            return std::chrono::milliseconds(std::max<int64_t>((deadline - monotonicNs()) / 1000000, 0));
+        };
+
+        // The shutdown message queues behind any spilled violations
+        while (!flushSpill(std::chrono::milliseconds(50)) && remaining().count() > 0) {}
+        if (!flushSpill() || avnReaped ||
+            !avnQueue->trySend(makeIpcMessage(IpcMessageType::Shutdown), remaining())) {
+            deadline = monotonicNs();
+        }
+        shutdownDeadlineNs = deadline;
+        if (settlementThread.joinable()) {
+            settlementThread.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(spillMutex);
+            dropped += spill.size();
+            spill.clear();
+        }
+
+        for (pid_t pid : children) {
+            if (pid == avnPid && avnReaped) continue;
+            int status = 0;
+            while (waitpid(pid, &status, WNOHANG) == 0) {
+                if (remaining().count() == 0) {
+                    ::kill(pid, SIGKILL);
+                    waitpid(pid, &status, 0);
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        children.clear();
+        IpcQueue::removeAll();
+    }
+
+    // Call after shutdown
+    void printReport() {
+        const char* stageNames[kIpcStageCount] = {
+            "Violation -> AVN", "AVN -> Portal", "Portal -> StripePay", "End to end"
+        };
+        double seconds = lastSettleNs > firstSubmitNs ? (lastSettleNs - firstSubmitNs) / 1e9 : 0.0;
+
+        ProfiledLock consoleLock(g_console_mutex);
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        std::cout << "\n=== IPC PIPELINE BENCHMARK ===\n";
+        std::cout << "Processes: controller, AVN generator, " << portals
+                  << " airline portal(s), StripePay\n";
+        std::cout << "Violations: " << submitted.load() << " | Settled: " << settled
+                  << " | Declined: " << declined << "\n";
+        std::cout << "Spilled: " << spilled.load() << " | Dropped: " << dropped.load() << "\n";
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Throughput: " << (seconds > 0.0 ? settled / seconds : 0.0) << " settlements/s\n";
+        std::cout << std::setprecision(3);
+        std::cout << std::left << std::setw(20) << "Stage (ms)" << std::right
+                  << std::setw(10) << "p50" << std::setw(10) << "p95"
+                  << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+        for (int stage = 0; stage < kIpcStageCount; stage++) {
+            std::vector<int64_t>& samples = stageLatencyNs[stage];
+            std::sort(samples.begin(), samples.end());
+            std::cout << std::left << std::setw(20) << stageNames[stage] << std::right
+                      << std::setw(10) << percentileMs(samples, 0.50)
+                      << std::setw(10) << percentileMs(samples, 0.95)
+                      << std::setw(10) << percentileMs(samples, 0.99)
+                      << std::setw(10) << percentileMs(samples, 1.0) << "\n";
+        }
+        std::cout << "============================\n";
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+};
+
+// std::mutex that counts acquisitions and how many of them had to wait
+class CountingMutex {
+private:
+    std::mutex mutex;
+    std::atomic<uint64_t> acquisitions;
+    std::atomic<uint64_t> contended;
+    const char* name;
+
+public:
+    explicit CountingMutex(const char* n = "mutex") : acquisitions(0), contended(0), name(n) {}
+
+    void lock() {
+        if (!mutex.try_lock()) {
+            contended++;
+            TraceScope wait(name, "lock");
+            mutex.lock();
+        }
+        acquisitions++;
+    }
+
+    bool try_lock() {
+        if (mutex.try_lock()) {
+            acquisitions++;
+            return true;
+        }
+        return false;
+    }
+
+    void unlock() {
+        mutex.unlock();
+    }
+
+    uint64_t acquisitionCount() const { return acquisitions.load(); }
+    uint64_t contendedCount() const { return contended.load(); }
+};
+
+// Coroutine runtime for flight lifecycles
+// Fire-and-forget coroutine type; the frame frees itself when the lifecycle ends
+struct FlightTask {
+    struct promise_type {
+        AllocCount allocations;  // Counted while the lifecycle runs, with --alloc-profile
+        int flightNumber;
+
+        // Every co_await resumes through here, so the allocations made
+        // between suspensions are charged to this lifecycle
+        template <typename Awaitable>
+        struct CountedAwaiter {
+            Awaitable awaitable;
+            AllocCount* count;
+
+            bool await_ready() { return awaitable.await_ready(); }
+            auto await_suspend(std::coroutine_handle<promise_type> handle) {
+                AllocTracker::lifecycleCount = nullptr;
+                return awaitable.await_suspend(handle);
+            }
+            decltype(auto) await_resume() {
+                AllocTracker::lifecycleCount = count;
+                return awaitable.await_resume();
+            }
+        };
+
+        struct Start {
+            AllocCount* count;
+            bool await_ready() noexcept { return true; }
+            void await_suspend(std::coroutine_handle<>) noexcept {}
+            void await_resume() noexcept { AllocTracker::lifecycleCount = count; }
+        };
+
+        template <typename Owner>
+        promise_type(Owner&, Flight& flight) : flightNumber(flight.flightNumber) {}
+        ~promise_type() { AllocTracker::endLifecycle(flightNumber, allocations); }
+
+        template <typename Awaitable>
+        CountedAwaiter<Awaitable> await_transform(Awaitable&& awaitable) {
+            return {std::forward<Awaitable>(awaitable), &allocations};
+        }
+
+        FlightTask get_return_object() { return {}; }
+        Start initial_suspend() noexcept { return {&allocations}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Fixed-size thread pool with one deque per worker. Owners pop from the back,
+// idle workers steal from the front of other workers' deques.
+class WorkStealingExecutor {
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::coroutine_handle<>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex idleMutex;
+    std::condition_variable idleCondition;
+    std::atomic<size_t> pendingTasks;
+    std::atomic<size_t> nextQueue;
+    std::atomic<bool> running;
+
+    static inline thread_local WorkStealingExecutor* currentExecutor = nullptr;
+    static inline thread_local size_t currentIndex = 0;
+
+    bool popLocal(size_t index, std::coroutine_handle<>& task) {
+        WorkerQueue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t index, std::coroutine_handle<>& task) {
+        for (size_t offset = 1; offset < queues.size(); offset++) {
+            WorkerQueue& victim = *queues[(index + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(size_t index) {
+        currentExecutor = this;
+        currentIndex = index;
+        g_tracer.nameThread("lifecycle-worker");
+        AllocTracker::tagThread(AllocSubsystem::Lifecycle);
+
+        while (true) {
+            std::coroutine_handle<> task;
+            if (popLocal(index, task) || steal(index, task)) {
+                pendingTasks--;
+                task.resume();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(idleMutex);
+            idleCondition.wait(lock, [this] { return pendingTasks.load() > 0 || !running.load(); });
+            if (!running.load() && pendingTasks.load() == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    explicit WorkStealingExecutor(size_t threadCount)
+        : pendingTasks(0), nextQueue(0), running(true)
+    {
+        if (threadCount == 0) threadCount = 1;
+        for (size_t i = 0; i < threadCount; i++) {
+            queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        for (size_t i = 0; i < threadCount; i++) {
+            workers.emplace_back(&WorkStealingExecutor::workerLoop, this, i);
+        }
+    }
+
+    ~WorkStealingExecutor() {
+        shutdown();
+    }
+
+    // Queue a suspended coroutine; workers post to their own deque
+    void post(std::coroutine_handle<> task) {
+        size_t index = (currentExecutor == this) ? currentIndex
+                                                  : nextQueue++ % queues.size();
+        // Counted before it is visible, so a worker that pops it at once
+        // never takes the count below zero
+        pendingTasks++;
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(task);
+        }
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+        }
+        idleCondition.notify_one();
+    }
+
+    // Run remaining tasks to completion and join all workers
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            running = false;
+        }
+        idleCondition.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    size_t threadCount() const { return queues.size(); }
+};
+
+// Single timer thread that hands expired coroutines back to the executor
+class CoroutineTimer {
+private:
+    struct TimerEntry {
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t sequence;
+        std::coroutine_handle<> handle;
+
+        bool operator>(const TimerEntry& other) const {
+            if (deadline != other.deadline) return deadline > other.deadline;
+            return sequence > other.sequence;
+        }
+    };
+
+    WorkStealingExecutor& executor;
+    std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>> timers;
+    std::mutex timerMutex;
+    std::condition_variable timerCondition;
+    uint64_t nextSequence;
+    bool running;
+    std::thread timerThread;
+
+    void run() {
+        g_tracer.nameThread("coroutine-timer");
+        AllocTracker::tagThread(AllocSubsystem::Timer);
+        std::unique_lock<std::mutex> lock(timerMutex);
+        std::vector<std::coroutine_handle<>> due;
+
+        while (running) {
+            if (timers.empty()) {
+                timerCondition.wait(lock);
+                continue;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            while (!timers.empty() && timers.top().deadline <= now) {
+                due.push_back(timers.top().handle);
+                timers.pop();
+            }
+
+            if (!due.empty()) {
+                lock.unlock();
+                for (auto handle : due) {
+                    executor.post(handle);
+                }
+                due.clear();
+                lock.lock();
+                continue;
+            }
+
+            timerCondition.wait_until(lock, timers.top().deadline);
+        }
+    }
+
+public:
+    explicit CoroutineTimer(WorkStealingExecutor& exec)
+        : executor(exec), nextSequence(0), running(true)
+    {
+        timerThread = std::thread(&CoroutineTimer::run, this);
+    }
+
+    ~CoroutineTimer() {
+        stop();
+    }
+
+    void schedule(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(timerMutex);
+            if (running) {
+                bool earliest = timers.empty() || deadline < timers.top().deadline;
+                timers.push({deadline, nextSequence++, handle});
+                if (earliest) {
+                    timerCondition.notify_one();
+                }
+                return;
+            }
+        }
+        // Timer already stopped: resume straight away so the lifecycle can wind down
+        executor.post(handle);
+    }
+
+    // Stop the timer thread and release every pending coroutine early
+    void stop() {
+        std::vector<std::coroutine_handle<>> pending;
+        {
+            std::lock_guard<std::mutex> lock(timerMutex);
+            if (!running) return;
+            running = false;
+            while (!timers.empty()) {
+                pending.push_back(timers.top().handle);
+                timers.pop();
+            }
+        }
+        timerCondition.notify_all();
+        if (timerThread.joinable()) {
+            timerThread.join();
+        }
+        for (auto handle : pending) {
+            executor.post(handle);
+        }
+    }
+};
+
+// co_await PhaseDelay{timer, duration} suspends a lifecycle without holding a thread
+struct PhaseDelay {
+    CoroutineTimer& timer;
+    std::chrono::steady_clock::duration delay;
+
+    bool await_ready() const noexcept { return delay <= std::chrono::steady_clock::duration::zero(); }
+    void await_suspend(std::coroutine_handle<> handle) {
+        timer.schedule(std::chrono::steady_clock::now() + delay, handle);
+    }
+    void await_resume() const noexcept {}
+};
+
+// co_await ExecutorHop{executor} moves the current coroutine onto the pool
+struct ExecutorHop {
+    WorkStealingExecutor& executor;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { executor.post(handle); }
+    void await_resume() const noexcept {}
+};
+
+// Keeps a live-lifecycle count so shutdown can wait for every frame to finish
+struct LifecycleGuard {
+    std::atomic<int>& counter;
+    explicit LifecycleGuard(std::atomic<int>& c) : counter(c) { counter++; }
+    ~LifecycleGuard() { counter--; }
+};
+
+// Keeps a flight's current phase span open while its lifecycle runs
+struct PhaseTraceGuard {
+    Flight& flight;
+    explicit PhaseTraceGuard(Flight& f) : flight(f) { flight.traceEnterPhase(); }
+    ~PhaseTraceGuard() { flight.traceLeavePhase(); }
+};
+
+// Saturation test settings; rates are offered flights per simulated hour
+struct SaturationConfig {
+    double startRatePerHour = 60.0;
+    double rateStepPerHour = 60.0;
+    int stepMinutes = 30;            // Simulated minutes per load step
+    int maxSteps = 20;
+    double timeScale = 60.0;         // Simulated seconds per wall-clock second
+    int maxQueueGrowth = 10;         // Queue depth growth per step that counts as diverging
+    double maxMeanWaitSeconds = 900; // Mean runway queue wait that counts as diverging
+};
+
+// Measurements for one load step of the saturation test
+struct SaturationStep {
+    double offeredRatePerHour;
+    double achievedRatePerHour;
+    double meanWaitSeconds;
+    size_t queueDepthStart;
+    size_t queueDepthEnd;
+    size_t queueDepthMax;
+    double cpuUtilization;           // CPU seconds per wall-clock second
+    long residentSetKB;
+    uint64_t lockAcquisitions;
+    uint64_t lockContended;
+    bool sustainable;
+};
+
+// Monte Carlo capacity planning settings. Each scenario draws its runway
+// count and its schedule and emergency scaling from these ranges.
+struct MonteCarloConfig {
+    int scenarios = 1000;
+    double hours = 4.0;               // Simulated hours per scenario
+    uint64_t seed = 1;
+    int minRunways = 2;
+    int maxRunways = 5;
+    double minIntervalScale = 0.5;    // Multiplies schedule intervals
+    double maxIntervalScale = 1.5;
+    double minEmergencyScale = 0.5;   // Multiplies emergency probabilities
+    double maxEmergencyScale = 2.0;
+    int threads = 0;                  // 0 uses every core
+};
+
+struct ScenarioResult {
+    int runways;
+    double intervalScale;
+    double emergencyScale;
+    uint64_t flights;
+    uint64_t grants;
+    uint64_t faults;
+    uint64_t violations;
+    size_t queuedAtEnd;
+    double meanWaitSeconds;
+    double p95WaitSeconds;
+    double grantsPerHour;
+    double violationsPerHour;
+    double finesPerHour;
+};
+
+// Process CPU time (user + system) in seconds
+double processCpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// Current resident set size from /proc, 0 if unavailable
+long residentSetKB() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            return std::stol(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+// End-of-run report inputs: one compact record per flight of the run, with
+// AVN fines per airline taken from the AVN analytics store
+constexpr int kReportDirections = 4;
+constexpr int kReportTimelineBuckets = 24;
+
+struct ReportFlight {
+    int32_t flightNumber;
+    uint16_t airline;       // Index into RunReportInput::airlines
+    uint8_t direction;
+    uint8_t state;          // 0 in progress, 1 completed, 2 ended on a ground fault
+    int32_t delayMs;        // Runway and gate waits
+    int16_t runway;         // -1 if the flight never entered a runway
+    uint16_t violations;
+    int64_t runwayEnterMs;  // Simulated ms; exit is -1 while still on the runway
+    int64_t runwayExitMs;
+};
+
+struct RunReportInput {
+    std::vector<std::string> airlines;
+    std::vector<std::string> runways;
+    std::vector<AVNAnalytics::FineTotals> fines;  // Indexed like airlines
+    std::vector<ReportFlight> flights;
+    int64_t durationMs = 0;
+};
+
+// Delay percentiles, violation rates, fines and runway utilization over a
+// whole run. build() gives each thread a contiguous slice of the flights to
+// aggregate, then selects every group's percentiles on the threads in turn,
+// so reports over millions of flights take well under a second per core.
+class RunReport {
+public:
+    struct DelayStats {
+        uint64_t flights = 0;
+        double meanMs = 0.0;
+        int64_t p50Ms = 0;
+        int64_t p90Ms = 0;
+        int64_t p99Ms = 0;
+        int64_t maxMs = 0;
+    };
+
+    struct AirlineRow {
+        std::string name;
+        uint64_t flights = 0;
+        uint64_t completed = 0;
+        uint64_t faulted = 0;
+        uint64_t violations = 0;
+        DelayStats delay;
+        AVNAnalytics::FineTotals fines;
+    };
+
+    struct RunwayRow {
+        std::string name;
+        uint64_t movements = 0;
+        double utilization = 0.0;
+        std::array<double, kReportTimelineBuckets> timeline{};  // Busy fraction per bucket
+    };
+
+    std::vector<AirlineRow> airlines;
+    std::array<DelayStats, kReportDirections> directions;
+    std::vector<RunwayRow> runways;
+    DelayStats delay;
+    uint64_t flights = 0;
+    uint64_t completed = 0;
+    uint64_t faulted = 0;
+    uint64_t violations = 0;
+    int64_t durationMs = 0;
+    int64_t bucketMs = 0;
+    int threads = 1;
+    double buildMs = 0.0;
+
+private:
+    // Calls body(i) for i in [0, count) on `threads` threads, the caller included
+    template <typename Body>
+    static void parallelFor(size_t count, int threads, Body body) {
+        std::atomic<size_t> next(0);
+        auto work = [&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                body(i);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; t++) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Reorders delays; each percentile is selected from the tail left by the previous one
+    static DelayStats delayStats(std::vector<int32_t>& delays) {
+        DelayStats stats;
+        stats.flights = delays.size();
+        if (delays.empty()) return stats;
+        int64_t total = 0;
+        for (int32_t value : delays) total += value;
+        stats.meanMs = static_cast<double>(total) / delays.size();
+
+        auto from = delays.begin();
+        auto select = [&](double p) {
+            auto at = delays.begin() + static_cast<size_t>(p * (delays.size() - 1) + 0.5);
+            std::nth_element(from, at, delays.end());
+            from = at;
+            return static_cast<int64_t>(*at);
+        };
+        stats.p50Ms = select(0.50);
+        stats.p90Ms = select(0.90);
+        stats.p99Ms = select(0.99);
+        stats.maxMs = *std::max_element(from, delays.end());
+        return stats;
+    }
+
+    static void writeDelayJson(std::ostream& out, const DelayStats& stats) {
+        out << "{\"flights\":" << stats.flights << ",\"meanMs\":" << stats.meanMs << ",\"p50Ms\":" << stats.p50Ms
+            << ",\"p90Ms\":" << stats.p90Ms << ",\"p99Ms\":" << stats.p99Ms << ",\"maxMs\":" << stats.maxMs << "}";
+    }
+
+public:
+    static RunReport build(const RunReportInput& input, int threadCount) {
+        auto started = std::chrono::steady_clock::now();
+        RunReport report;
+        const size_t airlineCount = input.airlines.size();
+        const size_t runwayCount = input.runways.size();
+        report.durationMs = std::max<int64_t>(input.durationMs, 1);
+        report.bucketMs = (report.durationMs + kReportTimelineBuckets - 1) / kReportTimelineBuckets;
+
+        // Small runs are not worth the thread start-up
+        constexpr size_t kMinSlice = 65536;
+        const size_t flightCount = input.flights.size();
+        report.threads = static_cast<int>(std::clamp<size_t>(flightCount / kMinSlice, 1, std::max(threadCount, 1)));
+
+        // Delay groups: each airline, each direction, then the whole run
+        const size_t groupCount = airlineCount + kReportDirections + 1;
+        struct Partial {
+            std::vector<uint64_t> flights;     // Per airline
+            std::vector<uint64_t> completed;
+            std::vector<uint64_t> faulted;
+            std::vector<uint64_t> violations;
+            std::vector<std::vector<int32_t>> delays;  // Per group, completed flights only
+            std::vector<int64_t> busyMs;       // Runway-major, kReportTimelineBuckets per runway
+            std::vector<uint64_t> movements;   // Per runway
+        };
+        std::vector<Partial> partials(report.threads);
+
+        parallelFor(partials.size(), report.threads, [&](size_t slice) {
+            Partial& partial = partials[slice];
+            partial.flights.assign(airlineCount, 0);
+            partial.completed.assign(airlineCount, 0);
+            partial.faulted.assign(airlineCount, 0);
+            partial.violations.assign(airlineCount, 0);
+            partial.delays.resize(groupCount);
+            partial.busyMs.assign(runwayCount * kReportTimelineBuckets, 0);
+            partial.movements.assign(runwayCount, 0);
+
+            size_t begin = flightCount * slice / partials.size();
+            size_t end = flightCount * (slice + 1) / partials.size();
+            for (size_t i = begin; i < end; i++) {
+                const ReportFlight& flight = input.flights[i];
+                if (flight.airline < airlineCount) {
+                    partial.flights[flight.airline]++;
+                    partial.violations[flight.airline] += flight.violations;
+                    if (flight.state == 1) {
+                        partial.completed[flight.airline]++;
+                        partial.delays[flight.airline].push_back(flight.delayMs);
+                    } else if (flight.state == 2) {
+                        partial.faulted[flight.airline]++;
+                    }
+                }
+                if (flight.state == 1) {
+                    if (flight.direction < kReportDirections) {
+                        partial.delays[airlineCount + flight.direction].push_back(flight.delayMs);
+                    }
+                    partial.delays[groupCount - 1].push_back(flight.delayMs);
+                }
+
+                if (flight.runway < 0 || static_cast<size_t>(flight.runway) >= runwayCount ||
+                    flight.runwayEnterMs < 0) {
+                    continue;
+                }
+                partial.movements[flight.runway]++;
+                int64_t from = std::min(flight.runwayEnterMs, report.durationMs);
+                int64_t to = flight.runwayExitMs < 0 ? report.durationMs
+                                                     : std::min(flight.runwayExitMs, report.durationMs);
+                int64_t* busy = &partial.busyMs[flight.runway * kReportTimelineBuckets];
+                for (int64_t bucket = from / report.bucketMs; from < to; bucket++) {
+                    int64_t bucketEnd = (bucket + 1) * report.bucketMs;
+                    busy[bucket] += std::min(to, bucketEnd) - from;
+                    from = bucketEnd;
+                }
+            }
+        });
+
+        // Counts merge in slice order; each group's delays are merged and
+        // selected by whichever thread takes the group
+        std::vector<DelayStats> groupStats(groupCount);
+        parallelFor(groupCount, report.threads, [&](size_t group) {
+            std::vector<int32_t> delays;
+            size_t total = 0;
+            for (const Partial& partial : partials) total += partial.delays[group].size();
+            delays.reserve(total);
+            for (Partial& partial : partials) {
+                delays.insert(delays.end(), partial.delays[group].begin(), partial.delays[group].end());
+                std::vector<int32_t>().swap(partial.delays[group]);
+            }
+            groupStats[group] = delayStats(delays);
+        });
+
+        report.airlines.resize(airlineCount);
+        for (size_t a = 0; a < airlineCount; a++) {
+            AirlineRow& row = report.airlines[a];
+            row.name = input.airlines[a];
+            for (const Partial& partial : partials) {
+                row.flights += partial.flights[a];
+                row.completed += partial.completed[a];
+                row.faulted += partial.faulted[a];
+                row.violations += partial.violations[a];
+            }
+            row.delay = groupStats[a];
+            if (a < input.fines.size()) row.fines = input.fines[a];
+            report.flights += row.flights;
+            report.completed += row.completed;
+            report.faulted += row.faulted;
+            report.violations += row.violations;
+        }
+        for (int d = 0; d < kReportDirections; d++) {
+            report.directions[d] = groupStats[airlineCount + d];
+        }
+        report.delay = groupStats[groupCount - 1];
+
+        report.runways.resize(runwayCount);
+        for (size_t r = 0; r < runwayCount; r++) {
+            RunwayRow& row = report.runways[r];
+            row.name = input.runways[r];
+            int64_t busyTotal = 0;
+            for (int bucket = 0; bucket < kReportTimelineBuckets; bucket++) {
+                int64_t busy = 0;
+                for (const Partial& partial : partials) busy += partial.busyMs[r * kReportTimelineBuckets + bucket];
+                int64_t length = std::min(report.bucketMs, report.durationMs - bucket * report.bucketMs);
+                row.timeline[bucket] = length > 0 ? std::min(1.0, static_cast<double>(busy) / length) : 0.0;
+                busyTotal += busy;
+            }
+            for (const Partial& partial : partials) row.movements += partial.movements[r];
+            row.utilization = std::min(1.0, static_cast<double>(busyTotal) / report.durationMs);
+        }
+
+        report.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        return report;
+    }
+
+    void print(std::ostream& out) const {
+        std::ios oldState(nullptr);
+        oldState.copyfmt(out);
+        out << std::fixed << std::setprecision(1);
+
+        out << "\n=== RUN REPORT ===\n";
+        out << "Flights: " << flights << " (" << completed << " completed, " << faulted << " faulted, "
+            << flights - completed - faulted << " in progress) | Simulated " << durationMs / 60000.0
+            << " min | Built in " << buildMs << " ms on " << threads << " thread" << (threads == 1 ? "" : "s") << "\n";
+
+        auto delayRow = [&](const std::string& name, const DelayStats& stats) {
+            out << "  " << std::left << std::setw(24) << name << std::right << std::setw(9) << stats.flights
+                << std::setw(9) << stats.meanMs / 1000.0 << std::setw(9) << stats.p50Ms / 1000.0
+                << std::setw(9) << stats.p90Ms / 1000.0 << std::setw(9) << stats.p99Ms / 1000.0
+                << std::setw(9) << stats.maxMs / 1000.0 << "\n";
+        };
+        out << "DELAY (runway + gate wait of completed flights, seconds):\n";
+        out << "  " << std::left << std::setw(24) << "" << std::right << std::setw(9) << "Flights" << std::setw(9)
+            << "Mean" << std::setw(9) << "p50" << std::setw(9) << "p90" << std::setw(9) << "p99" << std::setw(9)
+            << "Max" << "\n";
+        delayRow("All flights", delay);
+        for (const AirlineRow& row : airlines) delayRow(row.name, row.delay);
+        for (int d = 0; d < kReportDirections; d++) {
+            delayRow(Flight::directionName(static_cast<FlightDirection>(d)), directions[d]);
+        }
+
+        out << "VIOLATIONS AND FINES (PKR):\n";
+        out << "  " << std::left << std::setw(24) << "" << std::right << std::setw(9) << "Flights" << std::setw(11)
+            << "Violations" << std::setw(9) << "Per 100" << std::setw(14) << "AVNs paid" << std::setw(14)
+            << "Fines issued" << std::setw(14) << "Fines paid" << "\n";
+        for (const AirlineRow& row : airlines) {
+            out << "  " << std::left << std::setw(24) << row.name << std::right << std::setw(9) << row.flights
+                << std::setw(11) << row.violations << std::setw(9)
+                << (row.flights ? row.violations * 100.0 / row.flights : 0.0) << std::setw(14)
+                << (std::to_string(row.fines.paid) + "/" + std::to_string(row.fines.issued))
+                << std::setw(14) << row.fines.finesIssued << std::setw(14) << row.fines.finesPaid << "\n";
+        }
+
+        static const char levels[] = " .:-=+*#%@";
+        out << "RUNWAY UTILIZATION (" << kReportTimelineBuckets << " buckets of " << bucketMs / 1000.0 << "s):\n";
+        for (const RunwayRow& row : runways) {
+            out << "  " << std::left << std::setw(36) << row.name << std::right << std::setw(6)
+                << row.utilization * 100.0 << "% " << std::setw(7) << row.movements << " movements |";
+            for (double busy : row.timeline) {
+                out << levels[std::min(9, static_cast<int>(busy * 10.0))];
+            }
+            out << "|\n";
+        }
+        out << "============================\n";
+        out.copyfmt(oldState);
+    }
+
+    bool writeJson(const std::string& path) const {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) {
+            std::cerr << "Failed to write run report " << path << std::endl;
+            return false;
+        }
+        out << std::setprecision(12);
+        out << "{\"durationMs\":" << durationMs << ",\"flights\":" << flights << ",\"completed\":" << completed
+            << ",\"faulted\":" << faulted << ",\"violations\":" << violations << ",\"delay\":";
+        writeDelayJson(out, delay);
+        out << ",\n\"airlines\":[";
+        for (size_t i = 0; i < airlines.size(); i++) {
+            const AirlineRow& row = airlines[i];
+            out << (i ? ",\n" : "\n") << "{\"name\":\"";
+            Tracer::writeEscaped(out, row.name.c_str());
+            out << "\",\"flights\":" << row.flights << ",\"completed\":" << row.completed
+                << ",\"faulted\":" << row.faulted << ",\"violations\":" << row.violations
+                << ",\"avnsIssued\":" << row.fines.issued << ",\"avnsPaid\":" << row.fines.paid
+                << ",\"finesIssued\":" << row.fines.finesIssued << ",\"finesPaid\":" << row.fines.finesPaid
+                << ",\"delay\":";
+            writeDelayJson(out, row.delay);
+            out << "}";
+        }
+        out << "],\n\"directions\":[";
+        for (int d = 0; d < kReportDirections; d++) {
+            out << (d ? ",\n" : "\n") << "{\"name\":\"" << Flight::directionName(static_cast<FlightDirection>(d))
+                << "\",\"delay\":";
+            writeDelayJson(out, directions[d]);
+            out << "}";
+        }
+        out << "],\n\"runways\":{\"bucketMs\":" << bucketMs << ",\"runways\":[";
+        for (size_t i = 0; i < runways.size(); i++) {
+            const RunwayRow& row = runways[i];
+            out << (i ? ",\n" : "\n") << "{\"name\":\"";
+            Tracer::writeEscaped(out, row.name.c_str());
+            out << "\",\"movements\":" << row.movements << ",\"utilization\":" << row.utilization << ",\"timeline\":[";
+            for (int bucket = 0; bucket < kReportTimelineBuckets; bucket++) {
+                out << (bucket ? "," : "") << row.timeline[bucket];
+            }
+            out << "]}";
+        }
+        out << "]}}\n";
+        return static_cast<bool>(out);
+    }
+};
+
+// Flight telemetry. Lifecycles append raw samples into per-thread staging
+// buffers; full buffers are handed to a background encoder that writes them
+// as delta-encoded columnar chunks through memory-mapped windows of the file.
+struct TelemetrySample {
+    uint32_t timeMs;       // Simulated milliseconds since the simulation started
+    int32_t flightNumber;
+    float speed;
+    int8_t phase;
+    int8_t runway;         // -1 if none
+};
+
+const char kTelemetryMagic[8] = {'A', 'T', 'C', 'S', 'T', 'L', 'M', '1'};
+const uint32_t kTelemetryChunkMagic = 0x4B484354;  // "TCHK"
+
+struct TelemetryFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+// Each chunk is followed by its columns in this order. Time, flight number
+// and speed (in 0.1 km/h) are zigzag varint deltas from the previous sample.
+struct TelemetryChunkHeader {
+    uint32_t magic;
+    uint32_t sampleCount;
+    uint32_t timeBytes;
+    uint32_t flightBytes;
+    uint32_t phaseBytes;
+    uint32_t speedBytes;
+    uint32_t runwayBytes;
+    uint32_t reserved;
+};
+
+inline void appendVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool readVarint(const uint8_t*& cursor, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; cursor < end && shift < 64; shift += 7) {
+        uint8_t byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint64_t zigzagEncode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+class TelemetryRecorder {
+private:
+    static const size_t kSamplesPerChunk = 4096;
+    static const size_t kWindowBytes = 4 << 20;
+
+    struct ThreadBuffer {
+        std::vector<TelemetrySample> samples;
+    };
+
+    std::string path;
+    uint64_t recorderID;
+    std::mutex bufferMutex;
+    std::condition_variable bufferCondition;
+    std::vector<std::shared_ptr<ThreadBuffer>> threadBuffers;
+    std::deque<std::vector<TelemetrySample>> sealedChunks;
+    std::vector<std::vector<TelemetrySample>> freeChunks;
+    bool running;
+    std::thread encoderThread;
+
+    // Writer state, only touched by the encoder thread
+    bip::file_mapping file;
+    std::unique_ptr<bip::mapped_region> window;
+    uint64_t windowOffset;
+    uint64_t windowUsed;
+    uint64_t fileLength;
+    std::vector<uint8_t> encoded;
+    uint64_t samplesWritten;
+
+    static inline std::atomic<uint64_t> nextRecorderID{1};
+    static inline thread_local uint64_t cachedRecorderID = 0;
+    static inline thread_local ThreadBuffer* cachedBuffer = nullptr;
+
+    ThreadBuffer& localBuffer() {
+        if (cachedRecorderID != recorderID) {
+            auto buffer = std::make_shared<ThreadBuffer>();
+            buffer->samples.reserve(kSamplesPerChunk);
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            threadBuffers.push_back(buffer);
+            cachedBuffer = buffer.get();
+            cachedRecorderID = recorderID;
+        }
+        return *cachedBuffer;
+    }
+
+    void sealBuffer(ThreadBuffer& buffer) {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        sealedChunks.push_back(std::move(buffer.samples));
+        if (!freeChunks.empty()) {
+            buffer.samples = std::move(freeChunks.back());
+            freeChunks.pop_back();
+        } else {
+            buffer.samples = std::vector<TelemetrySample>();
+        }
+        buffer.samples.clear();
+        buffer.samples.reserve(kSamplesPerChunk);
+        bufferCondition.notify_one();
+    }
+
+    void encodeChunk(std::vector<TelemetrySample>& samples) {
+        // Samples from one thread are nearly time ordered already
+        std::stable_sort(samples.begin(), samples.end(),
+                         [](const TelemetrySample& a, const TelemetrySample& b) { return a.timeMs < b.timeMs; });
+
+        std::vector<uint8_t> timeColumn, flightColumn, phaseColumn, speedColumn, runwayColumn;
+        int64_t lastTime = 0, lastFlight = 0, lastSpeed = 0;
+        for (const auto& sample : samples) {
+            int64_t speedTenths = std::lround(sample.speed * 10.0f);
+            appendVarint(timeColumn, zigzagEncode(static_cast<int64_t>(sample.timeMs) - lastTime));
+            appendVarint(flightColumn, zigzagEncode(static_cast<int64_t>(sample.flightNumber) - lastFlight));
+            phaseColumn.push_back(static_cast<uint8_t>(sample.phase));
+            appendVarint(speedColumn, zigzagEncode(speedTenths - lastSpeed));
+            runwayColumn.push_back(static_cast<uint8_t>(sample.runway));
+            lastTime = sample.timeMs;
+            lastFlight = sample.flightNumber;
+            lastSpeed = speedTenths;
+        }
+
+        TelemetryChunkHeader header{};
+        header.magic = kTelemetryChunkMagic;
+        header.sampleCount = static_cast<uint32_t>(samples.size());
+        header.timeBytes = static_cast<uint32_t>(timeColumn.size());
+        header.flightBytes = static_cast<uint32_t>(flightColumn.size());
+        header.phaseBytes = static_cast<uint32_t>(phaseColumn.size());
+        header.speedBytes = static_cast<uint32_t>(speedColumn.size());
+        header.runwayBytes = static_cast<uint32_t>(runwayColumn.size());
+
+        encoded.clear();
+        const uint8_t* headerBytes = reinterpret_cast<const uint8_t*>(&header);
+        encoded.insert(encoded.end(), headerBytes, headerBytes + sizeof(header));
+        for (const auto* column : {&timeColumn, &flightColumn, &phaseColumn, &speedColumn, &runwayColumn}) {
+            encoded.insert(encoded.end(), column->begin(), column->end());
+        }
+        writeMapped(encoded.data(), encoded.size());
+        samplesWritten += samples.size();
+    }
+
+    // Copy bytes into the current mapped window, growing the file a window at a time
+    void writeMapped(const uint8_t* data, size_t length) {
+        while (length > 0) {
+            if (!window || windowUsed == window->get_size()) {
+                mapWindow(std::max<uint64_t>(kWindowBytes, length));
+            }
+            size_t room = window->get_size() - windowUsed;
+            size_t count = std::min(room, length);
+            std::memcpy(static_cast<char*>(window->get_address()) + windowUsed, data, count);
+            windowUsed += count;
+            data += count;
+            length -= count;
+        }
+    }
+
+    void mapWindow(uint64_t size) {
+        if (window) {
+            window->flush();
+            windowOffset += windowUsed;
+        }
+        fileLength = windowOffset + size;
+        std::filesystem::resize_file(path, fileLength);
+        window = std::make_unique<bip::mapped_region>(file, bip::read_write, windowOffset, size);
+        windowUsed = 0;
+    }
+
+    void encoderLoop() {
+        pinCurrentThread(g_lowLatency.workerCore, "telemetry encoder");
+        AllocTracker::tagThread(AllocSubsystem::Telemetry);
+        std::unique_lock<std::mutex> lock(bufferMutex);
+        while (true) {
+            bufferCondition.wait(lock, [this] { return !sealedChunks.empty() || !running; });
+            if (sealedChunks.empty() && !running) return;
+
+            std::vector<TelemetrySample> chunk = std::move(sealedChunks.front());
+            sealedChunks.pop_front();
+            lock.unlock();
+            encodeChunk(chunk);
+            lock.lock();
+            chunk.clear();
+            freeChunks.push_back(std::move(chunk));
+        }
+    }
+
+    static std::string createFile(const std::string& filePath) {
+        TelemetryFileHeader header{};
+        std::memcpy(header.magic, kTelemetryMagic, sizeof(header.magic));
+        header.version = 1;
+        std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!out) {
+            throw std::runtime_error("cannot create telemetry file " + filePath);
+        }
+        return filePath;
+    }
+
+public:
+    explicit TelemetryRecorder(const std::string& filePath)
+        : path(filePath), recorderID(nextRecorderID++), running(true),
+          file(createFile(filePath).c_str(), bip::read_write),
+          windowOffset(sizeof(TelemetryFileHeader)), windowUsed(0),
+          fileLength(sizeof(TelemetryFileHeader)), samplesWritten(0)
+    {
+        encoderThread = std::thread(&TelemetryRecorder::encoderLoop, this);
+    }
+
+    ~TelemetryRecorder() {
+        close();
+    }
+
+    // Hot path: one store into this thread's staging buffer
+    void record(uint32_t timeMs, int32_t flightNumber, FlightPhase phase, float speed, int runway) {
+        ThreadBuffer& buffer = localBuffer();
+        buffer.samples.push_back({timeMs, flightNumber, speed,
+                                  static_cast<int8_t>(phase), static_cast<int8_t>(runway)});
+        if (buffer.samples.size() >= kSamplesPerChunk) {
+            sealBuffer(buffer);
+        }
+    }
+
+    // Flush partial buffers and finish the file. Producers must have stopped.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            if (!running) return;
+            for (auto& buffer : threadBuffers) {
+                if (!buffer->samples.empty()) {
+                    sealedChunks.push_back(std::move(buffer->samples));
+                    buffer->samples.clear();
+                }
+            }
+            running = false;
+        }
+        bufferCondition.notify_all();
+        if (encoderThread.joinable()) {
+            encoderThread.join();
+        }
+
+        uint64_t used = windowOffset + windowUsed;
+        if (window) {
+            window->flush();
+            window.reset();
+        }
+        std::filesystem::resize_file(path, used);
+    }
+
+    uint64_t sampleCount() const { return samplesWritten; }
+};
+
+// Offline reader for telemetry files. Chunks are decoded one at a time
+// straight out of a read-only mapping, so full-day runs stream in bounded memory.
+class TelemetryReader {
+private:
+    bip::file_mapping file;
+    bip::mapped_region region;
+
+public:
+    explicit TelemetryReader(const std::string& path)
+        : file(path.c_str(), bip::read_only), region(file, bip::read_only)
+    {
+        if (region.get_size() < sizeof(TelemetryFileHeader) ||
+            std::memcmp(region.get_address(), kTelemetryMagic, sizeof(kTelemetryMagic)) != 0) {
+            throw std::runtime_error("not a telemetry file: " + path);
+        }
+    }
+
+    // Calls visit(sample) for every sample in file order; returns false on a corrupt chunk
+    template <typename Visitor>
+    bool forEachSample(Visitor visit) const {
+        const uint8_t* cursor = static_cast<const uint8_t*>(region.get_address()) + sizeof(TelemetryFileHeader);
+        const uint8_t* end = static_cast<const uint8_t*>(region.get_address()) + region.get_size();
+        std::vector<TelemetrySample> samples;
+
+        while (end - cursor >= static_cast<std::ptrdiff_t>(sizeof(TelemetryChunkHeader))) {
+            TelemetryChunkHeader header;
+            std::memcpy(&header, cursor, sizeof(header));
+            if (header.magic != kTelemetryChunkMagic) {
+                return false;
+            }
+            cursor += sizeof(header);
+
+            uint64_t columnBytes = uint64_t(header.timeBytes) + header.flightBytes + header.phaseBytes +
+                                   header.speedBytes + header.runwayBytes;
+            if (columnBytes > static_cast<uint64_t>(end - cursor) ||
+                header.phaseBytes != header.sampleCount || header.runwayBytes != header.sampleCount) {
+                return false;
+            }
+
+            const uint8_t* timeCursor = cursor;
+            const uint8_t* flightCursor = timeCursor + header.timeBytes;
+            const uint8_t* phaseColumn = flightCursor + header.flightBytes;
+            const uint8_t* speedCursor = phaseColumn + header.phaseBytes;
+            const uint8_t* runwayColumn = speedCursor + header.speedBytes;
+
+            samples.resize(header.sampleCount);
+            int64_t lastTime = 0, lastFlight = 0, lastSpeed = 0;
+            for (uint32_t i = 0; i < header.sampleCount; i++) {
+                uint64_t timeDelta, flightDelta, speedDelta;
+                if (!readVarint(timeCursor, flightCursor, timeDelta) ||
+                    !readVarint(flightCursor, phaseColumn, flightDelta) ||
+                    !readVarint(speedCursor, runwayColumn, speedDelta)) {
+                    return false;
+                }
+                lastTime += zigzagDecode(timeDelta);
+                lastFlight += zigzagDecode(flightDelta);
+                lastSpeed += zigzagDecode(speedDelta);
+                samples[i] = {static_cast<uint32_t>(lastTime), static_cast<int32_t>(lastFlight),
+                              lastSpeed / 10.0f, static_cast<int8_t>(phaseColumn[i]),
+                              static_cast<int8_t>(runwayColumn[i])};
+            }
+            for (const auto& sample : samples) {
+                visit(sample);
+            }
+            cursor += columnBytes;
+        }
+        return true;
+    }
+};
+
+// Offline analysis of a telemetry file: per-phase sample counts and speeds
+int printTelemetrySummary(const std::string& path) {
+    struct PhaseStats {
+        uint64_t samples = 0;
+        double speedTotal = 0.0;
+        float speedMax = 0.0f;
+    };
+    std::vector<PhaseStats> phases(kFlightPhaseCount);
+    std::map<int32_t, uint64_t> samplesPerFlight;
+    uint64_t totalSamples = 0;
+    uint32_t firstTime = UINT32_MAX, lastTime = 0;
+    bool intact = false;
+
+    try {
+        TelemetryReader reader(path);
+        intact = reader.forEachSample([&](const TelemetrySample& sample) {
+            totalSamples++;
+            firstTime = std::min(firstTime, sample.timeMs);
+            lastTime = std::max(lastTime, sample.timeMs);
+            samplesPerFlight[sample.flightNumber]++;
+            if (sample.phase >= 0 && sample.phase < kFlightPhaseCount) {
+                PhaseStats& stats = phases[sample.phase];
+                stats.samples++;
+                stats.speedTotal += sample.speed;
+                stats.speedMax = std::max(stats.speedMax, sample.speed);
+            }
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to read telemetry " << path << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "\n=== TELEMETRY SUMMARY ===\n";
+    std::cout << "File: " << path << (intact ? "" : " (truncated)") << "\n";
+    std::cout << "Samples: " << totalSamples << " | Flights: " << samplesPerFlight.size() << "\n";
+    if (totalSamples > 0) {
+        std::cout << "Time span: " << firstTime / 1000 << "s - " << lastTime / 1000 << "s\n";
+    }
+    std::cout << "FLIGHT PHASES:\n";
+    for (int i = 0; i < kFlightPhaseCount; i++) {
+        if (phases[i].samples == 0) continue;
+        std::cout << "  " << std::left << std::setw(20) << kFlightPhaseNames[i]
+                  << ": " << phases[i].samples << " samples, mean "
+                  << std::fixed << std::setprecision(1) << phases[i].speedTotal / phases[i].samples
+                  << " km/h, max " << phases[i].speedMax << " km/h\n";
+    }
+    std::cout << "============================\n";
+    return intact ? 0 : 1;
+}
+
+// Gate resource model. Each aircraft type has a calendar index: an ordered
+// set of (free-from time, gate) over every compatible gate, with occupied
+// gates keyed at the end of time. Allocation is immediate only: finding a
+// gate free now is one upper_bound in that set instead of a scan of all
+// gates. Flights that find none wait in a queue per aircraft type, ordered
+// by priority and then by arrival, so a freed gate picks its next flight
+// from at most one queue head per type it serves.
+class GateAllocator {
+public:
+    struct Gate {
+        int id;
+        std::string name;
+        uint8_t typeMask;      // Bit per AircraftType the gate can serve
+        int64_t freeFrom;      // Calendar key, kOccupied while a flight is at the gate
+        int64_t bookedAt;      // Start of the current booking, simulated ms
+        Flight* occupant;
+    };
+
+    struct Stats {
+        int gates;
+        int occupied;
+        double utilization;    // Busy gate time / available gate time
+        uint64_t assignments;
+        uint64_t waits;        // Assignments that had to queue for a gate
+        double meanWaitMs;
+        int64_t maxWaitMs;
+        size_t waiting;
+    };
+
+private:
+    struct Waiter {
+        Flight* flight;
+        std::coroutine_handle<> handle;
+        int64_t since;
+
+        // Highest priority (lowest level) first, then longest waiting
+        bool operator<(const Waiter& other) const {
+            if (flight->priorityLevel != other.flight->priorityLevel) {
+                return flight->priorityLevel < other.flight->priorityLevel;
+            }
+            if (since != other.since) return since < other.since;
+            return flight->flightNumber < other.flight->flightNumber;
+        }
+    };
+
+    static const int kTypeCount = 3;
+    static constexpr int64_t kOccupied = std::numeric_limits<int64_t>::max();
+
+    std::mutex gateMutex;
+    std::vector<Gate> gates;
+    std::set<std::pair<int64_t, int>> calendar[kTypeCount];
+    std::set<Waiter> waiters[kTypeCount];  // By the waiting flight's AircraftType
+    bool closed;           // Set at shutdown so late requests never queue
+    int64_t openedAt;
+    int64_t busyTotalMs;
+    uint64_t assignments;
+    uint64_t waitCount;
+    int64_t waitTotalMs;
+    int64_t waitMaxMs;
+
+    static uint8_t typeBit(AircraftType type) {
+        return static_cast<uint8_t>(1u << static_cast<int>(type));
+    }
+
+    void reindex(Gate& gate, int64_t newFreeFrom) {
+        for (int t = 0; t < kTypeCount; t++) {
+            if (gate.typeMask & (1u << t)) {
+                calendar[t].erase({gate.freeFrom, gate.id});
+                calendar[t].insert({newFreeFrom, gate.id});
+            }
+        }
+        gate.freeFrom = newFreeFrom;
+    }
+
+    // Book the compatible gate that became free most recently, leaving gates
+    // that have been idle longest for flights that need them
+    int book(Flight& flight, int64_t now) {
+        auto& index = calendar[static_cast<int>(flight.aircraftType)];
+        auto it = index.upper_bound({now, INT_MAX});
+        if (it == index.begin()) return -1;
+        --it;
+
+        Gate& gate = gates[it->second];
+        reindex(gate, kOccupied);
+        gate.bookedAt = now;
+        gate.occupant = &flight;
+        flight.gateAssigned = gate.id;
+        assignments++;
+        return gate.id;
+    }
+
+public:
+    GateAllocator() : closed(false), openedAt(0), busyTotalMs(0), assignments(0), waitCount(0), waitTotalMs(0), waitMaxMs(0) {}
+
+    void addGate(const std::string& name, std::initializer_list<AircraftType> types) {
+        Gate gate{static_cast<int>(gates.size()), name, 0, 0, 0, nullptr};
+        for (AircraftType type : types) {
+            gate.typeMask |= typeBit(type);
+        }
+        gates.push_back(gate);
+        for (int t = 0; t < kTypeCount; t++) {
+            if (gate.typeMask & (1u << t)) {
+                calendar[t].insert({0, gate.id});
+            }
+        }
+    }
+
+    // Hub layout: 70% passenger gates, 20% cargo stands, 10% remote stands for any type
+    void buildHubLayout(int gateCount) {
+        int passenger = gateCount * 7 / 10;
+        int cargo = gateCount * 2 / 10;
+        for (int i = 0; i < gateCount; i++) {
+            if (i < passenger) {
+                addGate("Gate P" + std::to_string(i + 1), {AircraftType::Commercial, AircraftType::Emergency});
+            } else if (i < passenger + cargo) {
+                addGate("Cargo C" + std::to_string(i - passenger + 1), {AircraftType::Cargo});
+            } else {
+                addGate("Remote R" + std::to_string(i - passenger - cargo + 1),
+                        {AircraftType::Commercial, AircraftType::Cargo, AircraftType::Emergency});
+            }
+        }
+    }
+
+    void open(int64_t now) {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        openedAt = now;
+        closed = false;
+    }
+
+    // Assign a gate now or queue the flight. Returns true if a gate was
+    // assigned and the caller should not suspend.
+    bool acquireOrWait(Flight& flight, int64_t now, std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        if (closed || book(flight, now) != -1) {
+            return true;
+        }
+        waiters[static_cast<int>(flight.aircraftType)].insert({&flight, handle, now});
+        return false;
+    }
+
+    int gateCount() {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        return static_cast<int>(gates.size());
+    }
+
+    // Re-occupy a gate when restoring a checkpoint
+    void occupy(int gateID, Flight& flight, int64_t now) {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        if (gateID < 0 || gateID >= static_cast<int>(gates.size())) {
+            flight.gateAssigned = -1;
+            return;
+        }
+        Gate& gate = gates[gateID];
+        reindex(gate, kOccupied);
+        gate.bookedAt = now;
+        gate.occupant = &flight;
+        flight.gateAssigned = gateID;
+    }
+
+    // Free the flight's gate. If a compatible flight is waiting, the gate goes
+    // to the best of the queue heads for the types it serves, and that
+    // flight's coroutine is returned for the caller to resume. O(log n).
+    std::coroutine_handle<> release(Flight& flight, int64_t now) {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        int gateID = flight.gateAssigned;
+        flight.gateAssigned = -1;
+        if (gateID < 0 || gateID >= static_cast<int>(gates.size())) {
+            return nullptr;
+        }
+
+        Gate& gate = gates[gateID];
+        if (gate.occupant != &flight) {
+            return nullptr;
+        }
+        busyTotalMs += std::max<int64_t>(0, now - gate.bookedAt);
+        gate.occupant = nullptr;
+        reindex(gate, now);
+
+        std::set<Waiter>* next = nullptr;
+        for (int t = 0; t < kTypeCount; t++) {
+            if (!(gate.typeMask & (1u << t)) || waiters[t].empty()) continue;
+            if (!next || *waiters[t].begin() < *next->begin()) {
+                next = &waiters[t];
+            }
+        }
+        if (!next) {
+            return nullptr;
+        }
+        Waiter waiter = *next->begin();
+        next->erase(next->begin());
+        book(*waiter.flight, now);
+        int64_t waited = now - waiter.since;
+        waitCount++;
+        waitTotalMs += waited;
+        waitMaxMs = std::max(waitMaxMs, waited);
+        return waiter.handle;
+    }
+
+    // Drop every waiter at shutdown and return their coroutines
+    std::vector<std::coroutine_handle<>> cancelWaiters() {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        std::vector<std::coroutine_handle<>> handles;
+        closed = true;
+        for (auto& queue : waiters) {
+            for (const auto& waiter : queue) {
+                handles.push_back(waiter.handle);
+            }
+            queue.clear();
+        }
+        return handles;
+    }
+
+    Stats stats(int64_t now) {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        Stats result{};
+        result.gates = static_cast<int>(gates.size());
+        int64_t busy = busyTotalMs;
+        for (const auto& gate : gates) {
+            if (gate.occupant) {
+                result.occupied++;
+                busy += std::max<int64_t>(0, now - gate.bookedAt);
+            }
+        }
+        int64_t available = (now - openedAt) * static_cast<int64_t>(gates.size());
+        result.utilization = available > 0 ? static_cast<double>(busy) / available : 0.0;
+        result.assignments = assignments;
+        result.waits = waitCount;
+        result.meanWaitMs = waitCount > 0 ? static_cast<double>(waitTotalMs) / waitCount : 0.0;
+        result.maxWaitMs = waitMaxMs;
+        for (const auto& queue : waiters) {
+            result.waiting += queue.size();
+        }
+        return result;
+    }
+
+    const std::vector<Gate>& allGates() const { return gates; }
+};
+
+// Flight status by flight number, for portal and control socket queries.
+// Each record is a snapshot written when the flight changes state, so a
+// query reads one shard under a shared lock and never waits on flightsMutex
+// or the runway dispatcher. A queued flight's runway ETA is not stored: it
+// moves with every grant and insertion ahead, so it is computed at query
+// time from the flight's queue key. Snapshots are built under the shard's
+// exclusive lock from live fields, so a late writer can never overwrite
+// newer state with older state.
+struct FlightStatus {
+    int flightNumber;
+    const Airline* airline;
+    AircraftType aircraftType;
+    FlightDirection direction;
+    EmergencyType emergencyType;
+    int priorityLevel;  // With the scheduled time and number, the runway queue key
+    std::chrono::system_clock::time_point scheduledTime;
+    FlightPhase phase;
+    float speed;
+    int runwayAssigned;
+    bool runwayOccupied;
+    int gateAssigned;
+    bool inRunwayQueue;
+    std::vector<int> avnIDs;
+    bool faulted;
+    std::string faultDescription;
+    bool complete;
+    int64_t updatedMs;
+};
+
+class FlightIndex {
+private:
+    static const size_t kShardCount = 64;
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<int, FlightStatus> records;
+    };
+
+    std::array<Shard, kShardCount> shards;
+
+    Shard& shardFor(int flightNumber) {
+        return shards[static_cast<size_t>(flightNumber) % kShardCount];
+    }
+
+public:
+    // Create or refresh a record; fill runs under the shard's exclusive lock
+    template <typename Fill>
+    void update(int flightNumber, Fill fill) {
+        Shard& shard = shardFor(flightNumber);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.records.try_emplace(flightNumber).first;
+        fill(it->second);
+    }
+
+    bool find(int flightNumber, FlightStatus& status) {
+        Shard& shard = shardFor(flightNumber);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.records.find(flightNumber);
+        if (it == shard.records.end()) return false;
+        status = it->second;
+        return true;
+    }
+
+    void clear() {
+        for (auto& shard : shards) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.records.clear();
+        }
+    }
+};
+
+// Simulator events. Each state change is published once as a compact value;
+// subscribers format, count or persist it on their own threads.
+enum class SimEventType : uint8_t {
+    FlightAdded,
+    PhaseChanged,
+    RunwayReserved,
+    RunwayGranted,
+    RunwayReleased,
+    GateAssigned,
+    GroundFault,
+    SpeedViolation,
+    SeparationConflict,
+    AVNIssued,
+    FlightDeparted
+};
+constexpr int kSimEventTypeCount = 11;
+
+struct SimEvent {
+    SimEventType type;
+    FlightPhase phase;
+    AircraftType aircraftType;
+    FlightDirection direction;
+    EmergencyType emergencyType;
+    uint8_t detail;       // Overflow grant, speed shown, GroundFault or ViolationKind, by type
+    int32_t flightNumber;
+    int32_t otherFlight;  // Separation partner
+    int32_t resourceID;   // Runway or gate
+    int32_t avnID;
+    float speed;
+    float limit;          // Permissible speed
+    float lateralKm;
+    float verticalM;
+    int64_t simulationMs;
+    const Airline* airline;       // Airlines live as long as the controller
+    const Airline* otherAirline;
+};
+
+// What a full subscriber queue does to the publisher
+enum class BackpressurePolicy {
+    DropNewest,  // Discard the new event
+    DropOldest,  // Discard the oldest queued event to make room
+    Block,       // Wait for room; only for lossless consumers that keep up
+    Grow         // Never full: append a segment, so nothing is dropped
+};
+
+// In-process event bus. Every subscriber has a queue of fixed-size segments
+// and a thread of its own, so publishing costs one short lock per interested
+// subscriber and a slow subscriber only ever affects its own queue, as its
+// policy allows. Queued events are never moved: a Grow queue takes another
+// segment instead of copying, and drained segments are reused.
+// Subscribe before the first publish.
+class EventBus {
+public:
+    using Handler = std::function<void(const SimEvent&)>;
+    static constexpr uint32_t kAllEvents = ~0u;
+
+    static constexpr uint32_t eventBit(SimEventType type) {
+        return 1u << static_cast<int>(type);
+    }
+
+private:
+    static const size_t kHandlerBatch = 256;
+    static const size_t kSegmentEvents = 256;
+
+    using Segment = std::array<SimEvent, kSegmentEvents>;
+
+    struct Subscriber {
+        std::string name;
+        uint32_t mask;
+        BackpressurePolicy policy;
+        Handler handler;
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;  // Also signalled after every handled batch
+        std::deque<std::unique_ptr<Segment>> segments;  // Queued events start at head of the front one
+        std::vector<std::unique_ptr<Segment>> spare;     // Drained segments kept for reuse
+        size_t spareLimit = 0;  // Segments kept beyond this after a Grow backlog are freed
+        size_t capacity = 0;    // Bound on count, except for Grow
+        size_t head = 0;
+        size_t count = 0;
+        uint64_t enqueued = 0;  // Sequence of the last event queued
+        uint64_t retired = 0;   // Events queued so far that were handled or evicted
+        bool stopping = false;
+        uint64_t delivered = 0;
+        uint64_t dropped = 0;
+        uint64_t blocked = 0;  // Publishes that waited for room
+        uint64_t grown = 0;    // Segments allocated beyond the initial capacity
+        size_t maxDepth = 0;
+        std::thread thread;
+
+        void push(const SimEvent& event) {
+            size_t tail = head + count;
+            if (tail / kSegmentEvents == segments.size()) {
+                if (spare.empty()) {
+                    spare.push_back(std::make_unique<Segment>());
+                    grown++;
+                }
+                segments.push_back(std::move(spare.back()));
+                spare.pop_back();
+            }
+            (*segments[tail / kSegmentEvents])[tail % kSegmentEvents] = event;
+            count++;
+            enqueued++;
+        }
+
+        const SimEvent& front() const { return (*segments.front())[head]; }
+
+        void pop() {
+            count--;
+            if (++head == kSegmentEvents || count == 0) {
+                // Keep the front segment when it is the only one, so a queue
+                // that hovers around empty does not cycle segments
+                if (head == kSegmentEvents || segments.size() > 1) {
+                    if (spare.size() < spareLimit) spare.push_back(std::move(segments.front()));
+                    segments.pop_front();
+                }
+                head = 0;
+            }
+        }
+    };
+
+    std::vector<std::unique_ptr<Subscriber>> subscribers;
+    std::atomic<uint64_t> published{0};
+
+    static const char* policyName(BackpressurePolicy policy) {
+        switch (policy) {
+            case BackpressurePolicy::DropNewest: return "drop-newest";
+            case BackpressurePolicy::DropOldest: return "drop-oldest";
+            case BackpressurePolicy::Block: return "block";
+            case BackpressurePolicy::Grow: return "grow";
+        }
+        return "unknown";
+    }
+
+    static void run(Subscriber& subscriber) {
+        g_tracer.nameThread(subscriber.name.c_str());
+        AllocTracker::tagThread(AllocSubsystem::Events);
+        pinCurrentThread(g_lowLatency.workerCore, subscriber.name.c_str());
+        std::vector<SimEvent> batch;
+        batch.reserve(kHandlerBatch);
+        std::unique_lock<std::mutex> lock(subscriber.mutex);
+        while (true) {
+            subscriber.notEmpty.wait(lock, [&] { return subscriber.count > 0 || subscriber.stopping; });
+            if (subscriber.count == 0) return;
+
+            while (subscriber.count > 0 && batch.size() < kHandlerBatch) {
+                batch.push_back(subscriber.front());
+                subscriber.pop();
+            }
+            lock.unlock();
+            subscriber.notFull.notify_all();
+
+            for (const SimEvent& event : batch) {
+                subscriber.handler(event);
+            }
+
+            lock.lock();
+            subscriber.delivered += batch.size();
+            subscriber.retired += batch.size();
+            batch.clear();
+            subscriber.notFull.notify_all();
+        }
+    }
+
+public:
+    ~EventBus() {
+        shutdown();
+    }
+
+    // Segments for capacity events are allocated up front; only a Grow
+    // queue allocates more, one segment at a time on the publisher's thread
+    void subscribe(const std::string& name, uint32_t mask, BackpressurePolicy policy, size_t capacity,
+                   Handler handler) {
+        auto subscriber = std::make_unique<Subscriber>();
+        subscriber->name = name;
+        subscriber->mask = mask;
+        subscriber->policy = policy;
+        subscriber->handler = std::move(handler);
+        subscriber->capacity = std::max<size_t>(capacity, 1);
+        // One extra segment, since a full queue need not start at a segment boundary
+        subscriber->spareLimit = (subscriber->capacity - 1) / kSegmentEvents + 2;
+        for (size_t i = 0; i < subscriber->spareLimit; i++) {
+            subscriber->spare.push_back(std::make_unique<Segment>());
+        }
+        subscriber->thread = std::thread(&EventBus::run, std::ref(*subscriber));
+        subscribers.push_back(std::move(subscriber));
+    }
+
+    void publish(const SimEvent& event) {
+        published.fetch_add(1, std::memory_order_relaxed);
+        uint32_t bit = eventBit(event.type);
+        for (auto& entry : subscribers) {
+            Subscriber& subscriber = *entry;
+            if (!(subscriber.mask & bit)) continue;
+
+            std::unique_lock<std::mutex> lock(subscriber.mutex);
+            if (subscriber.count >= subscriber.capacity && subscriber.policy != BackpressurePolicy::Grow) {
+                if (subscriber.policy == BackpressurePolicy::DropNewest) {
+                    subscriber.dropped++;
+                    continue;
+                } else if (subscriber.policy == BackpressurePolicy::DropOldest) {
+                    subscriber.pop();
+                    subscriber.retired++;
+                    subscriber.dropped++;
+                } else {
+                    subscriber.blocked++;
+                    subscriber.notFull.wait(lock, [&] {
+                        return subscriber.count < subscriber.capacity || subscriber.stopping;
+                    });
+                    if (subscriber.stopping) {
+                        subscriber.dropped++;
+                        continue;
+                    }
+                }
+            }
+            subscriber.push(event);
+            subscriber.maxDepth = std::max(subscriber.maxDepth, subscriber.count);
+            bool wake = subscriber.count == 1;
+            lock.unlock();
+            if (wake) {
+                subscriber.notEmpty.notify_one();
+            }
+        }
+    }
+
+    // Wait until every event queued before the call has been handled (or
+    // evicted). Events published meanwhile are not waited for, so this
+    // returns even while publishers outpace a subscriber.
+    void flush() {
+        for (auto& entry : subscribers) {
+            Subscriber& subscriber = *entry;
+            std::unique_lock<std::mutex> lock(subscriber.mutex);
+            uint64_t target = subscriber.enqueued;
+            subscriber.notFull.wait(lock, [&] { return subscriber.retired >= target || subscriber.stopping; });
+        }
+    }
+
+    // Handle what is queued, then stop the subscriber threads
+    void shutdown() {
+        for (auto& entry : subscribers) {
+            {
+                std::lock_guard<std::mutex> lock(entry->mutex);
+                entry->stopping = true;
+            }
+            entry->notEmpty.notify_all();
+            entry->notFull.notify_all();
+        }
+        for (auto& entry : subscribers) {
+            if (entry->thread.joinable()) {
+                entry->thread.join();
+            }
+        }
+    }
+
+    void printReport() {
+        ProfiledLock consoleLock(g_console_mutex);
+        std::cout << "\n=== EVENT BUS ===\n";
+        std::cout << "Published: " << published.load() << "\n";
+        std::cout << std::left << std::setw(17) << "Subscriber" << std::setw(13) << "Policy"
+                  << std::setw(10) << "Capacity" << std::setw(11) << "Delivered" << std::setw(9) << "Dropped"
+                  << std::setw(9) << "Blocked" << std::setw(7) << "Grown" << "MaxDepth\n";
+        for (auto& entry : subscribers) {
+            std::lock_guard<std::mutex> lock(entry->mutex);
+            std::cout << std::left << std::setw(17) << entry->name << std::setw(13) << policyName(entry->policy)
+                      << std::setw(10) << entry->capacity << std::setw(11) << entry->delivered
+                      << std::setw(9) << entry->dropped << std::setw(9) << entry->blocked
+                      << std::setw(7) << entry->grown << entry->maxDepth << "\n";
+        }
+        std::cout << std::right;
+        std::cout << "============================\n";
+    }
+};
+
+// Separation monitor. Airborne flights are bucketed into a uniform grid whose
+// cells are one lateral separation minimum wide, so any pair closer than the
+// minimum lies in the same or an adjacent cell. Each tick checks a cell
+// against itself and four of its neighbours, which is O(N) for bounded
+// density instead of comparing every pair.
+class SeparationMonitor {
+public:
+    static constexpr float kLateralMinimumKm = 9.26f;    // 5 NM
+    static constexpr float kVerticalMinimumM = 305.0f;   // 1000 ft
+
+    struct Conflict {
+        Flight* first;
+        Flight* second;
+        float lateralKm;
+        float verticalM;
+    };
+
+private:
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grid;
+    std::unordered_set<uint64_t> activePairs;
+    std::unordered_set<uint64_t> currentPairs;
+    uint64_t conflictsDetected;
+
+    static uint64_t cellKey(int32_t x, int32_t y) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    static uint64_t pairKey(const Flight* a, const Flight* b) {
+        uint64_t first = static_cast<uint32_t>(a->flightNumber);
+        uint64_t second = static_cast<uint32_t>(b->flightNumber);
+        return first < second ? (first << 32) | second : (second << 32) | first;
+    }
+
+    void checkPair(Flight* a, Flight* b, std::vector<Conflict>& newConflicts) {
+        float dx = a->posX - b->posX;
+        float dy = a->posY - b->posY;
+        float dz = std::fabs(a->altitude - b->altitude);
+        float lateralSq = dx * dx + dy * dy;
+        if (lateralSq >= kLateralMinimumKm * kLateralMinimumKm || dz >= kVerticalMinimumM) {
+            return;
+        }
+        uint64_t key = pairKey(a, b);
+        currentPairs.insert(key);
+        if (activePairs.insert(key).second) {
+            conflictsDetected++;
+            newConflicts.push_back({a, b, std::sqrt(lateralSq), dz});
+        }
+    }
+
+public:
+    SeparationMonitor() : conflictsDetected(0) {}
+
+    // Rebuild the grid from this tick's positions and return conflicts that
+    // started this tick; a pair is reported again only after it separates
+    std::vector<Conflict> update(const std::vector<Flight*>& airborne) {
+        std::vector<Conflict> newConflicts;
+
+        // Keep cell vectors between ticks; drop the map when it gets sparse
+        if (grid.size() > 4 * airborne.size() + 64) {
+            grid.clear();
+        }
+        for (auto& cell : grid) {
+            cell.second.clear();
+        }
+        for (uint32_t i = 0; i < airborne.size(); i++) {
+            int32_t x = static_cast<int32_t>(std::floor(airborne[i]->posX / kLateralMinimumKm));
+            int32_t y = static_cast<int32_t>(std::floor(airborne[i]->posY / kLateralMinimumKm));
+            grid[cellKey(x, y)].push_back(i);
+        }
+
+        currentPairs.clear();
+        static const int kNeighbours[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+        for (const auto& cell : grid) {
+            const std::vector<uint32_t>& members = cell.second;
+            if (members.empty()) continue;
+            int32_t x = static_cast<int32_t>(cell.first >> 32);
+            int32_t y = static_cast<int32_t>(cell.first & 0xFFFFFFFFu);
+
+            for (size_t i = 0; i < members.size(); i++) {
+                for (size_t j = i + 1; j < members.size(); j++) {
+                    checkPair(airborne[members[i]], airborne[members[j]], newConflicts);
+                }
+            }
+            for (const auto& offset : kNeighbours) {
+                auto neighbour = grid.find(cellKey(x + offset[0], y + offset[1]));
+                if (neighbour == grid.end()) continue;
+                for (uint32_t a : members) {
+                    for (uint32_t b : neighbour->second) {
+                        checkPair(airborne[a], airborne[b], newConflicts);
+                    }
+                }
+            }
+        }
+
+        activePairs.swap(currentPairs);
+        return newConflicts;
+    }
+
+    size_t activeConflicts() const { return activePairs.size(); }
+    uint64_t totalConflicts() const { return conflictsDetected; }
+};
+
+// ATCS Controller class
+class ATCSController {
+private:
+    std::vector<Airline> airlines;
+    std::vector<std::unique_ptr<Runway>> runways;
+    std::vector<std::unique_ptr<Flight>> flights;  // Changed to unique_ptr
+    std::vector<AVN> avns;
+    std::unique_ptr<AVNGenerator> avnGenerator;
+    AVNAnalytics avnAnalytics;  // Guarded by avnMutex
+
+    ProfiledMutex<CountingMutex> flightsMutex;
+    ProfiledMutex<std::mutex> avnMutex;
+    std::atomic<bool> simulationRunning;
+    std::chrono::steady_clock::time_point simulationStartTime;
+    std::chrono::seconds simulationDuration;
+
+    // Flight scheduling system
+    struct FlightSchedule {
+        FlightDirection direction;
+        int intervalSeconds;
+        float emergencyProbability;
+        std::string description;
+        EmergencyType emergencyType;
+    };
+
+    std::vector<FlightSchedule> flightSchedules;
+    std::atomic<bool> flightGenerationRunning;
+    std::vector<std::chrono::steady_clock::time_point> nextFlightTimes;  // Guarded by flightsMutex
+    std::atomic<unsigned int> flightNumberCounter;
+    std::chrono::milliseconds restoredElapsed;  // Simulated time carried over from a checkpoint
+    double timeScale;  // Simulated seconds per wall-clock second
+    bool headless;     // Skip the periodic dashboard when running unattended
+    std::atomic<double> offeredRatePerHour;  // Overrides schedule intervals when > 0
+    ArrivalProcess arrivalProcess;
+    double meanBurstSize;  // Flights per burst for ArrivalProcess::Bursty
+
+    // Built once from airlines and schedules so spawning a flight never
+    // scans airlines or compares names. Indexed [schedule][isEmergency].
+    std::vector<std::array<std::vector<size_t>, 2>> candidateTables;
+    std::vector<double> scheduleShare;  // Fraction of all traffic per schedule
+
+    // Runway grant statistics used by the saturation test
+    std::atomic<uint64_t> runwayGrants;
+    std::atomic<uint64_t> runwayWaitTotalMs;
+
+    // Dispatch latency. dispatchRequestNs holds the time of the oldest
+    // queued flight or runway release the dispatcher has not yet seen.
+    // Samples are only kept in low-latency mode; the vectors are only
+    // touched by the dispatcher thread and read after it has been joined.
+    std::atomic<int64_t> dispatchRequestNs;
+    std::vector<int64_t> dispatchLatencyNs;  // Request to dispatch pass
+    std::vector<int64_t> tickLatenessNs;     // Wake-up past the scheduled tick
+
+    // Emergency runway reservations, guarded by flightsMutex. A reservation
+    // keeps a runway for an inbound emergency that will ask for one at dueMs.
+    struct RunwayReservation {
+        Flight* flight = nullptr;
+        int64_t dueMs = 0;
+    };
+    std::vector<RunwayReservation> reservations;
+    std::vector<int64_t> emergencyGrantMs[kEmergencyTypeCount];  // Request to grant per EmergencyType
+    uint64_t emergencySloMisses[kEmergencyTypeCount];
+
+    // Runway use per movement. Approach and climb happen off the runway, so
+    // an arrival is granted its slot one approach ahead of touchdown.
+    static constexpr std::chrono::seconds kApproachTime{8};
+    static constexpr std::chrono::seconds kLandingRollTime{6};
+    static constexpr std::chrono::seconds kTakeoffRollTime{3};
+    int64_t separationBufferMs[kRunwayClassCount];  // Runway kept clear after each exit
+    std::atomic<uint64_t> runwayMovements;
+
+    // One ordered queue per RunwayClass, so a flight waiting for a busy
+    // runway never blocks flights that another free runway could take.
+    // Each queue is a rank-augmented tree, so insertion, removal and a
+    // flight's rank are all O(log n) whatever the queue depth; an emergency
+    // inserted near the front no longer renumbers the flights behind it.
+    class RunwayQueues {
+    private:
+        // Queue order: priority level (lower number = higher priority), then
+        // scheduled time (earlier first), then flight number
+        struct Key {
+            int priorityLevel;
+            std::chrono::system_clock::time_point scheduledTime;
+            int flightNumber;
+
+            bool operator<(const Key& other) const {
+                if (priorityLevel != other.priorityLevel) return priorityLevel < other.priorityLevel;
+                if (scheduledTime != other.scheduledTime) return scheduledTime < other.scheduledTime;
+                return flightNumber < other.flightNumber;
+            }
+        };
+
+        struct KeyOf {
+            using result_type = Key;
+            Key operator()(const Flight* flight) const {
+                return {flight->priorityLevel, flight->scheduledTime, flight->flightNumber};
+            }
+        };
+
+        using Queue = boost::multi_index_container<
+            Flight*, bmi::indexed_by<bmi::ranked_unique<KeyOf>>>;
+
+        Queue queues[kRunwayClassCount];
+        std::atomic<size_t> depth[kRunwayClassCount] = {};  // Readable without flightsMutex
+        // Changes hold flightsMutex and this exclusively, so status queries
+        // can rank a flight under a shared lock without flightsMutex
+        mutable std::shared_mutex rankMutex;
+
+    public:
+        static RunwayClass classFor(AircraftType type, FlightDirection direction) {
+            if (type == AircraftType::Cargo || type == AircraftType::Emergency) {
+                return RunwayClass::CargoEmergency;
+            }
+            if (direction == FlightDirection::NorthArrival || direction == FlightDirection::SouthArrival) {
+                return RunwayClass::Arrival;
+            }
+            return RunwayClass::Departure;
+        }
+
+        static RunwayClass classFor(const Flight& flight) {
+            return classFor(flight.aircraftType, flight.direction);
+        }
+
+        void push(Flight* flight) {
+            int c = static_cast<int>(classFor(*flight));
+            std::unique_lock<std::shared_mutex> lock(rankMutex);
+            queues[c].insert(flight);
+            depth[c] = queues[c].size();
+        }
+
+        bool empty(RunwayClass c) const { return queues[static_cast<int>(c)].empty(); }
+        // Safe to call without flightsMutex
+        size_t size(RunwayClass c) const { return depth[static_cast<int>(c)].load(); }
+        Flight* top(RunwayClass c) const { return *queues[static_cast<int>(c)].begin(); }
+
+        void pop(RunwayClass c) {
+            auto& queue = queues[static_cast<int>(c)];
+            std::unique_lock<std::shared_mutex> lock(rankMutex);
+            queue.erase(queue.begin());
+            depth[static_cast<int>(c)] = queue.size();
+        }
+
+        size_t size() const {
+            size_t total = 0;
+            for (const auto& queue : queues) total += queue.size();
+            return total;
+        }
+
+        // Flights ahead of this one in its class queue
+        int64_t rank(const Flight& flight) const {
+            const Queue& queue = queues[static_cast<int>(classFor(flight))];
+            return static_cast<int64_t>(queue.rank(queue.find(KeyOf()(&flight))));
+        }
+
+        // Rank from a status snapshot, without flightsMutex; -1 if the flight
+        // has left the queue since the snapshot was taken
+        int64_t rank(const FlightStatus& status) const {
+            const Queue& queue = queues[static_cast<int>(classFor(status.aircraftType, status.direction))];
+            std::shared_lock<std::shared_mutex> lock(rankMutex);
+            auto it = queue.find(Key{status.priorityLevel, status.scheduledTime, status.flightNumber});
+            return it == queue.end() ? -1 : static_cast<int64_t>(queue.rank(it));
+        }
+
+        void remove(Flight& flight) {
+            int c = static_cast<int>(classFor(flight));
+            std::unique_lock<std::shared_mutex> lock(rankMutex);
+            queues[c].erase(KeyOf()(&flight));
+            depth[c] = queues[c].size();
+        }
+
+        void clear() {
+            std::unique_lock<std::shared_mutex> lock(rankMutex);
+            for (int c = 0; c < kRunwayClassCount; c++) {
+                queues[c].clear();
+                depth[c] = 0;
+            }
+        }
+
+        // Visit every queued flight class by class, each class in queue
+        // order, with its rank in that class
+        template <typename Visit>
+        void forEach(Visit visit) const {
+            for (const auto& queue : queues) {
+                int64_t rank = 0;
+                for (Flight* flight : queue) visit(*flight, rank++);
+            }
+        }
+
+        // Flights class by class, each in queue order
+        std::vector<Flight*> ordered() const {
+            std::vector<Flight*> result;
+            for (const auto& queue : queues) {
+                result.insert(result.end(), queue.begin(), queue.end());
+            }
+            return result;
+        }
+    };
+
+    // Predicts runway grant times and owns each runway's next free slot. A
+    // runway is blocked only while a movement uses it (landing roll to exit,
+    // takeoff roll to liftoff) plus its separation buffer, so freeAtMs is
+    // when the next touchdown or takeoff roll may start. A class queue
+    // drains through its home runway at the class's mean slot length, so a
+    // queued flight is expected to be granted when that runway frees up plus
+    // its rank times the mean slot. Overflow runways make this a
+    // conservative estimate. Slot lengths are learned from runway exits, so
+    // nothing is re-simulated.
+    class RunwayEtaModel {
+    private:
+        struct RunwayState {
+            std::atomic<int64_t> freeAtMs{0};      // Next slot start, simulated ms
+            std::atomic<int64_t> enteredAtMs{-1};  // -1 while nobody is on the runway
+            std::atomic<int> enteredClass{0};
+        };
+
+        std::unique_ptr<RunwayState[]> runwayStates;
+        std::atomic<int64_t> holdMs[kRunwayClassCount];  // Moving average of observed slots
+
+    public:
+        explicit RunwayEtaModel(size_t runwayCount) : runwayStates(new RunwayState[runwayCount]) {
+            // Seeded from the lifecycle's runway use: a 6 s landing roll or a
+            // 3 s takeoff roll (cargo/emergency mixes both), plus the default
+            // separation buffers
+            holdMs[static_cast<int>(RunwayClass::Arrival)] = 8000;
+            holdMs[static_cast<int>(RunwayClass::Departure)] = 4000;
+            holdMs[static_cast<int>(RunwayClass::CargoEmergency)] = 5500;
+        }
+
+        void seedHold(RunwayClass runwayClass, int64_t slotMs) {
+            holdMs[static_cast<int>(runwayClass)] = slotMs;
+        }
+
+        // A granted movement claims the runway until slotEndMs
+        void onGrant(int runwayID, int64_t slotEndMs) {
+            runwayStates[runwayID].freeAtMs = slotEndMs;
+        }
+
+        void onEnter(int runwayID, RunwayClass runwayClass, int64_t nowMs) {
+            RunwayState& state = runwayStates[runwayID];
+            state.enteredClass = static_cast<int>(runwayClass);
+            state.enteredAtMs = nowMs;
+        }
+
+        void onRelease(int runwayID, int64_t nowMs, int64_t bufferMs) {
+            RunwayState& state = runwayStates[runwayID];
+            int64_t enteredAt = state.enteredAtMs.exchange(-1);
+            int64_t clearAt = nowMs + bufferMs;
+            if (state.freeAtMs.load() < clearAt) {
+                state.freeAtMs = clearAt;
+            }
+            if (enteredAt >= 0 && clearAt > enteredAt) {
+                auto& average = holdMs[state.enteredClass.load()];
+                average = (average.load() * 7 + (clearAt - enteredAt)) / 8;
+            }
+        }
+
+        int64_t freeAtMs(int runwayID) const { return runwayStates[runwayID].freeAtMs.load(); }
+        int64_t meanHoldMs(RunwayClass runwayClass) const { return holdMs[static_cast<int>(runwayClass)].load(); }
+    };
+
+    // Ground faults as competing exponential hazards, one per aircraft type
+    // and fault kind. A flight draws its time to fault once when a ground
+    // phase starts, so the cost is per phase rather than per tick and the
+    // fault rate no longer depends on how often anything polls. The
+    // defaults match the old 5% chance per 100 ms tick, split evenly.
+    class GroundFaultModel {
+    private:
+        double ratePerSecond[3][kGroundFaultCount];  // Indexed by AircraftType
+
+    public:
+        struct Sample {
+            std::chrono::steady_clock::duration after;  // Simulated time until the fault
+            GroundFault kind;
+        };
+
+        GroundFaultModel() {
+            double each = -std::log(0.95) / 0.1 / kGroundFaultCount;
+            for (auto& type : ratePerSecond) {
+                std::fill(std::begin(type), std::end(type), each);
+            }
+        }
+
+        void setRate(AircraftType type, GroundFault kind, double perSecond) {
+            ratePerSecond[static_cast<int>(type)][static_cast<int>(kind)] = std::max(0.0, perSecond);
+        }
+
+        double rate(AircraftType type, GroundFault kind) const {
+            return ratePerSecond[static_cast<int>(type)][static_cast<int>(kind)];
+        }
+
+        // The first of several exponential clocks fires after Exp(sum of
+        // rates) and is each kind with probability proportional to its rate
+        template <typename Generator>
+        Sample sample(AircraftType type, Generator& gen) const {
+            const double* rates = ratePerSecond[static_cast<int>(type)];
+            double total = 0.0;
+            for (int k = 0; k < kGroundFaultCount; k++) total += rates[k];
+            if (total <= 0.0) {
+                return {std::chrono::hours(24 * 365), GroundFault::BrakeFailure};
+            }
+
+            double seconds = std::min(std::exponential_distribution<double>(total)(gen), 3.0e7);
+            double pick = std::uniform_real_distribution<double>(0.0, total)(gen);
+            int kind = 0;
+            while (kind < kGroundFaultCount - 1 && pick >= rates[kind]) {
+                pick -= rates[kind];
+                kind++;
+            }
+            return {std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(seconds)),
+                    static_cast<GroundFault>(kind)};
+        }
+
+        Sample sample(AircraftType type) const {
+            static thread_local std::mt19937_64 gen(std::random_device{}());
+            return sample(type, gen);
+        }
+    };
+
+    RunwayQueues runwayQueues;
+    std::unique_ptr<RunwayEtaModel> etaModel;
+    GroundFaultModel groundFaults;
+    RunwayClassMasks runwayMasks;           // Fixed once the layout is configured
+    std::atomic<RunwayMask> freeRunways;    // Runways with no outstanding grant
+    std::vector<int> runwayGrantsOutstanding;  // Granted, not yet released; guarded by flightsMutex
+    RunwayMask reservedRunways;             // Held for an emergency; guarded by flightsMutex
+
+    bip::managed_shared_memory segment;
+    SharedRunwayStatus* sharedRunwayStatus;
+
+    // Flight lifecycles run as coroutines on a pool sized to the cores
+    std::unique_ptr<WorkStealingExecutor> lifecycleExecutor;
+    std::unique_ptr<CoroutineTimer> lifecycleTimer;
+    std::atomic<int> activeLifecycles;
+
+    std::unique_ptr<TelemetryRecorder> telemetry;  // Null unless telemetry is enabled
+    std::string runReportPath;  // JSON copy of the end-of-run report, if set
+
+    // Gates and turnaround time per AircraftType
+    std::unique_ptr<GateAllocator> gateAllocator;
+    std::chrono::seconds gateTurnaround[3];
+
+    // Set when the AVN generator, portal and StripePay run as separate processes
+    std::unique_ptr<IpcPipeline> ipcPipeline;
+
+    // Status snapshots for queries that must not take flightsMutex
+    FlightIndex flightIndex;
+
+    // Airborne separation, owned by the airspace thread
+    SeparationMonitor separationMonitor;
+    std::atomic<size_t> airborneCount;
+    std::atomic<size_t> activeConflicts;
+    std::atomic<uint64_t> totalConflicts;
+
+    // Banners, counters and AVN records are produced by event subscribers.
+    // Declared last so its threads stop before anything they use is destroyed.
+    std::array<std::atomic<uint64_t>, kSimEventTypeCount> eventCounts{};
+    EventBus events;
+
+public:
+    ATCSController() : 
+        flightsMutex("flightsMutex", "flightsMutex wait"),
+        avnMutex("avnMutex"),
+        simulationRunning(false), 
+        flightGenerationRunning(false),
+        simulationDuration(std::chrono::seconds(300)), // 5 minutes
+        flightNumberCounter(1000),
+        restoredElapsed(0),
+        timeScale(1.0),
+        headless(false),
+        offeredRatePerHour(0.0),
+        arrivalProcess(ArrivalProcess::Scheduled),
+        meanBurstSize(1.0),
+        runwayGrants(0),
+        runwayWaitTotalMs(0),
+        dispatchRequestNs(0),
+        emergencySloMisses{},
+        separationBufferMs{2000, 1000, 1000},
+        runwayMovements(0),
+        freeRunways(0),
+        reservedRunways(0),
+        segment(bip::open_or_create, "ATCSSharedMemory", 65536),
+        activeLifecycles(0),
+        airborneCount(0),
+        activeConflicts(0),
+        totalConflicts(0)
+    {
+        // Clean up old shared memory at startup
+        bip::shared_memory_object::remove("ATCSSharedMemory");
+        bip::shared_memory_object::remove("AVNSharedMemory");
+        bip::named_mutex::remove("AVNMutex");
+        
+        // Initialize shared memory
+        segment = bip::managed_shared_memory(bip::create_only, "ATCSSharedMemory", 65536);
+        sharedRunwayStatus = segment.construct<SharedRunwayStatus>("RunwayStatus")();
+
+        // Initialize airlines
+        airlines.emplace_back("PIA", AircraftType::Commercial, 6, 4);
+        airlines.emplace_back("AirBlue", AircraftType::Commercial, 4, 4);
+        airlines.emplace_back("FedEx Cargo", AircraftType::Cargo, 3, 2);
+        airlines.emplace_back("Pakistan Airforce", AircraftType::Emergency, 2, 1, EmergencyType::Military);
+        airlines.emplace_back("Blue Dart Cargo", AircraftType::Cargo, 2, 2);
+        airlines.emplace_back("AghaKhan Air Ambulance", AircraftType::Emergency, 2, 1, EmergencyType::Medical);
+
+        // Initialize runways
+        applyRunwayLayout(kDefaultRunwayLayout, kDefaultRunwayMasks);
+
+        // Initialize flight schedules with specific emergency types
+        flightSchedules = {
+            {FlightDirection::NorthArrival, 180, 0.10f, "International Arrivals", EmergencyType::DiversionOrLowFuel},
+            {FlightDirection::SouthArrival, 120, 0.05f, "Domestic Arrivals", EmergencyType::Medical},
+            {FlightDirection::EastDeparture, 150, 0.15f, "International Departures", EmergencyType::Military},
+            {FlightDirection::WestDeparture, 240, 0.20f, "Domestic Departures", EmergencyType::VIP}
+        };
+        buildCandidateTables();
+
+        // Initialize AVN Generator
+        avnGenerator = std::make_unique<AVNGenerator>();
+
+        // Initialize gates: turnaround per Commercial, Cargo, Emergency
+        configureGates(12);
+        gateTurnaround[static_cast<int>(AircraftType::Commercial)] = std::chrono::seconds(5);
+        gateTurnaround[static_cast<int>(AircraftType::Cargo)] = std::chrono::seconds(8);
+        gateTurnaround[static_cast<int>(AircraftType::Emergency)] = std::chrono::seconds(3);
+
+        // Initialize coroutine runtime
+        lifecycleExecutor = std::make_unique<WorkStealingExecutor>(std::thread::hardware_concurrency());
+        lifecycleTimer = std::make_unique<CoroutineTimer>(*lifecycleExecutor);
+
+        // The console keeps the latest banners if it falls behind; counters may
+        // drop under overload; AVN records must never be lost, and AVNs are
+        // issued from lifecycles, so the writer's queue grows by whole
+        // segments rather than stalling executor workers or dropping.
+        events.subscribe("event-console", EventBus::kAllEvents, BackpressurePolicy::DropOldest, 1 << 14,
+                         [this](const SimEvent& event) { logEvent(event); });
+        events.subscribe("event-analytics", EventBus::kAllEvents, BackpressurePolicy::DropNewest, 1 << 14,
+                         [this](const SimEvent& event) {
+                             eventCounts[static_cast<int>(event.type)].fetch_add(1, std::memory_order_relaxed);
+                         });
+        events.subscribe("avn-writer", EventBus::eventBit(SimEventType::AVNIssued), BackpressurePolicy::Grow,
+                         4096, [this](const SimEvent& event) { writeAVN(event); });
+    }
+
+    // Record flight samples to a telemetry file; call before startSimulation
+    bool enableTelemetry(const std::string& path) {
+        try {
+            telemetry = std::make_unique<TelemetryRecorder>(path);
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to open telemetry file " << path << ": " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    // Simulated milliseconds since the simulation started
+    int64_t simulationTimeMs() const {
+        auto simulated = toSimTime(std::chrono::steady_clock::now() - simulationStartTime);
+        return std::chrono::duration_cast<std::chrono::milliseconds>(simulated).count();
+    }
+
+    SimEvent flightEvent(SimEventType type, const Flight& flight) const {
+        SimEvent event{};
+        event.type = type;
+        event.phase = flight.phase;
+        event.aircraftType = flight.aircraftType;
+        event.direction = flight.direction;
+        event.emergencyType = flight.emergencyType;
+        event.flightNumber = flight.flightNumber;
+        event.resourceID = -1;
+        event.avnID = -1;
+        event.speed = flight.speed;
+        event.simulationMs = simulationTimeMs();
+        event.airline = flight.airline;
+        return event;
+    }
+
+    // Console subscriber: the banner for each event
+    void logEvent(const SimEvent& event) {
+        ProfiledLock consoleLock(g_console_mutex);
+        switch (event.type) {
+            case SimEventType::FlightAdded:
+                std::cout << "\n=== NEW FLIGHT ADDED ===\n";
+                std::cout << "Flight: #" << event.flightNumber << "\n";
+                std::cout << "Airline: " << event.airline->name << "\n";
+                std::cout << "Type: " << Flight::aircraftTypeName(event.aircraftType) << "\n";
+                std::cout << "Direction: " << Flight::directionName(event.direction) << "\n";
+                if (event.emergencyType != EmergencyType::None) {
+                    std::cout << "Emergency: " << Flight::emergencyTypeName(event.emergencyType) << "\n";
+                }
+                break;
+            case SimEventType::PhaseChanged:
+                std::cout << "\n=== PHASE TRANSITION ===\n";
+                std::cout << "Flight: #" << event.flightNumber << "\n";
+                std::cout << "New Phase: " << Flight::phaseName(event.phase) << "\n";
+                if (event.detail) {
+                    std::cout << "Speed: " << event.speed << " km/h\n";
+                }
+                break;
+            case SimEventType::RunwayReserved:
+                std::cout << "\n=== RUNWAY RESERVED ===\n";
+                std::cout << "Flight: #" << event.flightNumber << "\n";
+                std::cout << "Emergency: " << Flight::emergencyTypeName(event.emergencyType) << "\n";
+                std::cout << "Runway: " << runways[event.resourceID]->name << "\n";
+                break;
+            case SimEventType::RunwayGranted:
+                if (!event.detail) {
+                    std::cout << "\n=== RUNWAY ASSIGNMENT ===\n";
+                    std::cout << "Flight: #" << event.flightNumber << "\n";
+                    std::cout << "Runway: " << runways[event.resourceID]->name << "\n";
+                } else {
+                    std::cout << "\n=== OVERFLOW RUNWAY ASSIGNMENT ===\n";
+                    std::cout << "Flight: #" << event.flightNumber << "\n";
+                    std::cout << "Runway: " << runways[event.resourceID]->name << " (overflow)\n";
+                }
+                break;
+            case SimEventType::RunwayReleased:
+                std::cout << "\n=== RUNWAY RELEASED ===\n";
+                std::cout << "Flight: #" << event.flightNumber << "\n";
+                std::cout << "Runway: " << runways[event.resourceID]->name << "\n";
+                break;
+            case SimEventType::GateAssigned:
+                std::cout << "\n=== GATE ASSIGNMENT ===\n";
+                std::cout << "Flight: #" << event.flightNumber << "\n";
+                std::cout << "Gate: " << gateAllocator->allGates()[event.resourceID].name << "\n";
+                break;
+            case SimEventType::GroundFault:
+                std::cout << "\n=== GROUND FAULT DETECTED ===\n";
+                std::cout << "Flight: #" << event.flightNumber << "\n";
+                std::cout << "Fault: " << groundFaultName(static_cast<GroundFault>(event.detail)) << "\n";
+                std::cout << "Action: Aircraft being towed to maintenance\n";
+                break;
+            case SimEventType::SpeedViolation: {
+                float permissibleSpeed;
+                std::string reason;
+                speedLimitViolation(event.phase, event.speed, permissibleSpeed, reason);
+                std::cout << "\n=== SPEED VIOLATION DETECTED ===\n";
+                std::cout << "Flight: #" << event.flightNumber << " (" << event.airline->name << ")\n";
+                std::cout << "Phase: " << Flight::phaseName(event.phase) << "\n";
+                std::cout << "Speed: " << event.speed << " km/h (Limit: " << event.limit << " km/h)\n";
+                std::cout << "Reason: " << reason << "\n";
+                break;
+            }
+            case SimEventType::SeparationConflict:
+                std::cout << "\n=== SEPARATION CONFLICT ===\n";
+                std::cout << "Flights: #" << event.flightNumber << " (" << event.airline->name
+                          << ") and #" << event.otherFlight << " (" << event.otherAirline->name << ")\n";
+                std::cout << "Lateral: " << std::fixed << std::setprecision(2) << event.lateralKm
+                          << " km (min " << SeparationMonitor::kLateralMinimumKm << " km)\n";
+                std::cout << "Vertical: " << std::setprecision(0) << event.verticalM
+                          << " m (min " << SeparationMonitor::kVerticalMinimumM << " m)\n";
+                std::cout << std::defaultfloat << std::setprecision(6);
+                break;
+            case SimEventType::AVNIssued:
+                std::cout << "\n=== AVN GENERATED ===\n";
+                std::cout << "AVN ID: #" << event.avnID << "\n";
+                std::cout << "Flight: #" << event.flightNumber << "\n";
+                std::cout << "Airline: " << event.airline->name << "\n";
+                std::cout << "Fine: PKR " << std::fixed << std::setprecision(2)
+                          << AVNGenerator::fineAmountFor(event.aircraftType) << "\n";
+                std::cout << std::defaultfloat << std::setprecision(6);
+                break;
+            case SimEventType::FlightDeparted:
+                std::cout << "Flight #" << event.flightNumber << " departed from airspace.\n";
+                break;
+        }
+        std::cout << "============================\n";
+    }
+
+    // AVN writer subscriber: the shared-memory record for an issued AVN. With
+    // the multi-process pipeline the AVN process writes it instead.
+    void writeAVN(const SimEvent& event) {
+        if (ipcPipeline) return;
+        avnGenerator->recordAVN(event.avnID, event.airline->name.c_str(), event.flightNumber,
+                                event.aircraftType, static_cast<int>(event.phase),
+                                static_cast<ViolationKind>(event.detail), event.speed, event.limit, true);
+    }
+
+    // A lifecycle step changed the flight: sample telemetry and refresh its status
+    void recordFlightState(const Flight& flight) {
+        AllocScope allocScope(AllocSubsystem::Telemetry);
+        if (telemetry) {
+            telemetry->record(static_cast<uint32_t>(simulationTimeMs()),
+                              flight.flightNumber, flight.phase, flight.speed, flight.runwayAssigned);
+        }
+        publishStatus(flight);
+    }
+
+    // Refresh a flight's status snapshot
+    void publishStatus(const Flight& flight) {
+        flightIndex.update(flight.flightNumber, [&](FlightStatus& status) {
+            status.flightNumber = flight.flightNumber;
+            status.airline = flight.airline;
+            status.aircraftType = flight.aircraftType;
+            status.direction = flight.direction;
+            status.emergencyType = flight.emergencyType;
+            status.priorityLevel = flight.priorityLevel;
+            status.scheduledTime = flight.scheduledTime;
+            status.phase = flight.phase;
+            status.speed = flight.speed;
+            status.runwayAssigned = flight.runwayAssigned;
+            status.runwayOccupied = flight.runwayOccupied;
+            status.gateAssigned = flight.gateAssigned;
+            status.inRunwayQueue = flight.inRunwayQueue;
+            {
+                ProfiledLock avnLock(avnMutex);
+                status.avnIDs = flight.avnIDs;
+            }
+            status.faulted = flight.hasFault;
+            status.faultDescription = flight.faultDescription;
+            status.complete = flight.lifecycleComplete;
+            status.updatedMs = simulationTimeMs();
+        });
+    }
+
+    // Refresh only a flight's AVN list. For the airspace thread, which holds
+    // none of the locks guarding the other fields publishStatus copies.
+    void publishAVNs(const Flight& flight) {
+        flightIndex.update(flight.flightNumber, [&](FlightStatus& status) {
+            {
+                ProfiledLock avnLock(avnMutex);
+                status.avnIDs = flight.avnIDs;
+            }
+            status.updatedMs = simulationTimeMs();
+        });
+    }
+
+    // Status query by flight number; never waits on the dispatcher
+    bool flightStatus(int flightNumber, FlightStatus& status) {
+        return flightIndex.find(flightNumber, status);
+    }
+
+    // Build the runways; masks come precomputed for the built-in layout
+    template <typename Layout>
+    void applyRunwayLayout(const Layout& layout, const RunwayClassMasks& masks) {
+        static const char* const roleNames[kRunwayClassCount] = {"Arrivals", "Departures", "Cargo/Emergency"};
+        runways.clear();
+        int id = 0;
+        for (const RunwaySpec& spec : layout) {
+            std::string name;
+            if (spec.name) {
+                name = spec.name;
+            } else {
+                char buffer[64];
+                std::snprintf(buffer, sizeof(buffer), "RWY-%02d (%s)", id + 1, roleNames[static_cast<int>(spec.home)]);
+                name = buffer;
+                if ((spec.capabilities | runwayClassBit(spec.home)) != kAllRunwayClasses) {
+                    name += " [";
+                    for (int c = 0; c < kRunwayClassCount; c++) {
+                        if (spec.capabilities & (1u << c)) name += "ADC"[c];
+                    }
+                    name += "]";
+                }
+            }
+            runways.push_back(std::make_unique<Runway>(id, name, spec.home, spec.capabilities));
+            id++;
+        }
+        runwayMasks = masks;
+        etaModel = std::make_unique<RunwayEtaModel>(runways.size());
+        reservations.assign(runways.size(), RunwayReservation{});
+        reservedRunways = 0;
+        runwayGrantsOutstanding.assign(runways.size(), 0);
+        freeRunways = runways.size() == kMaxRunways ? ~RunwayMask{0} : (RunwayMask{1} << runways.size()) - 1;
+    }
+
+    // Parse a layout such as "arrival:a*2,departure:d*2,cargo": comma-separated
+    // ROLE[:CLASSES][*COUNT] entries, where ROLE is arrival, departure or cargo
+    // and CLASSES lists the classes served (a, d, c; default all). Call before
+    // startSimulation and before --runway-buffer seeds the ETA model.
+    bool configureRunways(const std::string& spec) {
+        std::vector<RunwaySpec> layout;
+        std::istringstream entries(spec);
+        std::string entry;
+        while (std::getline(entries, entry, ',')) {
+            int count = 1;
+            size_t star = entry.find('*');
+            if (star != std::string::npos) {
+                try {
+                    count = std::stoi(entry.substr(star + 1));
+                } catch (const std::exception&) {
+                    count = 0;
+                }
+                entry.resize(star);
+            }
+            size_t colon = entry.find(':');
+            std::string role = entry.substr(0, colon);
+            RunwaySpec runway{RunwayClass::Arrival, kAllRunwayClasses};
+            if (role == "arrival") runway.home = RunwayClass::Arrival;
+            else if (role == "departure") runway.home = RunwayClass::Departure;
+            else if (role == "cargo") runway.home = RunwayClass::CargoEmergency;
+            else count = 0;
+            if (colon != std::string::npos) {
+                runway.capabilities = 0;
+                for (char letter : entry.substr(colon + 1)) {
+                    if (letter == 'a') runway.capabilities |= runwayClassBit(RunwayClass::Arrival);
+                    else if (letter == 'd') runway.capabilities |= runwayClassBit(RunwayClass::Departure);
+                    else if (letter == 'c') runway.capabilities |= runwayClassBit(RunwayClass::CargoEmergency);
+                    else count = 0;
+                }
+            }
+            runway.capabilities |= runwayClassBit(runway.home);
+            if (count <= 0) {
+                std::cerr << "Bad runway entry '" << entry << "', expected arrival|departure|cargo[:adc][*N]\n";
+                return false;
+            }
+            if (static_cast<size_t>(count) > kMaxRunways - layout.size()) {
+                std::cerr << "A runway layout needs 1 to " << kMaxRunways << " runways\n";
+                return false;
+            }
+            layout.insert(layout.end(), count, runway);
+        }
+        if (layout.empty()) {
+            std::cerr << "A runway layout needs 1 to " << kMaxRunways << " runways\n";
+            return false;
+        }
+        RunwayClassMasks masks = runwayClassMasks(layout);
+        for (int c = 0; c < kRunwayClassCount; c++) {
+            if (!masks.capable[c]) {
+                std::cerr << "Runway layout '" << spec << "' has no runway for "
+                          << (c == 0 ? "arrivals" : c == 1 ? "departures" : "cargo/emergency traffic") << "\n";
+                return false;
+            }
+        }
+        applyRunwayLayout(layout, masks);
+        return true;
+    }
+
+    // Replace the gate layout with a hub of gateCount gates; call before start
+    void configureGates(int gateCount) {
+        gateAllocator = std::make_unique<GateAllocator>();
+        gateAllocator->buildHubLayout(std::max(gateCount, 1));
+    }
+
+    // Run the AVN generator, airline portals and StripePay as child processes
+    void enableMultiProcess(int portals, bool quiet) {
+        ipcPipeline = std::make_unique<IpcPipeline>(portals, quiet);
+    }
+
+    // Push synthetic violations through the process pipeline as fast as it
+    // accepts them and report latency and throughput
+    void runIpcBenchmark(uint64_t count) {
+        std::vector<std::unique_ptr<Flight>> probes;
+        for (size_t i = 0; i < airlines.size(); i++) {
+            probes.push_back(std::make_unique<Flight>(90000 + static_cast<int>(i), &airlines[i], airlines[i].type,
+                                                      FlightDirection::NorthArrival,
+                                                      std::chrono::system_clock::now()));
+            probes.back()->updateSpeed(650.0f);
+        }
+        for (uint64_t i = 0; i < count; i++) {
+            issueAVN(*probes[i % probes.size()], 600.0f, ViolationKind::Speed);
+        }
+        ipcPipeline->shutdown();
+        ipcPipeline->printReport();
+    }
+
+    // Must be set before restoring a checkpoint or starting the simulation
+    void setTimeScale(double scale) {
+        timeScale = scale > 0.0 ? scale : 1.0;
+    }
+
+    // Add flight to system; false once the run has ended. The check is made
+    // under flightsMutex so shutdown can wait out a lifecycle being spawned.
+    bool addFlight(std::unique_ptr<Flight> flight) {
+        Flight* flightPtr = flight.get();
+        ProfiledLock lock(flightsMutex);
+        if (!simulationRunning) return false;
+        events.publish(flightEvent(SimEventType::FlightAdded, *flight));
+        flights.push_back(std::move(flight));
+        publishStatus(*flightPtr);
+        spawnLifecycle(*flightPtr);
+        return true;
+    }
+
+    void announcePhaseTransition(const Flight& flight, bool showSpeed = true) {
+        SimEvent event = flightEvent(SimEventType::PhaseChanged, flight);
+        event.detail = showSpeed;
+        events.publish(event);
+    }
+
+    // Release the runway held by a flight, if any
+    void releaseFlightRunway(Flight& flight) {
+        // The dispatcher reads runway assignments under flightsMutex
+        ProfiledLock lock(flightsMutex);
+        if (flight.runwayAssigned == -1) return;
+        releaseRunway(flight);
+        flight.runwayAssigned = -1;
+        flight.runwayOccupied = false;
+    }
+
+    // Conversions between simulated time and the wall clock
+    std::chrono::steady_clock::duration toWallTime(std::chrono::steady_clock::duration simulated) const {
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(simulated / timeScale);
+    }
+
+    std::chrono::steady_clock::duration toSimTime(std::chrono::steady_clock::duration wall) const {
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(wall * timeScale);
+    }
+
+    PhaseDelay phaseDelay(std::chrono::steady_clock::duration delay) {
+        return PhaseDelay{*lifecycleTimer, toWallTime(delay)};
+    }
+
+    std::chrono::steady_clock::duration phaseElapsed(const Flight& flight) const {
+        return toSimTime(std::chrono::steady_clock::now() - flight.phaseStart);
+    }
+
+    // Delay for whatever is left of a phase of the given length
+    PhaseDelay phaseRemaining(const Flight& flight, std::chrono::steady_clock::duration length) {
+        return PhaseDelay{*lifecycleTimer, toWallTime(length - phaseElapsed(flight))};
+    }
+
+    // co_await RunwayGrant{*this, flight} queues the flight in runwayQueues and
+    // suspends until the dispatcher assigns a runway; false means shutdown
+    struct RunwayGrant {
+        ATCSController& controller;
+        Flight& flight;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            controller.enqueueForRunway(flight, handle);
+        }
+        bool await_resume() const noexcept { return flight.runwayAssigned != -1; }
+    };
+
+    // co_await GateGrant{*this, flight} books a compatible gate for the flight's
+    // turnaround, suspending until one frees up; false means shutdown
+    struct GateGrant {
+        ATCSController& controller;
+        Flight& flight;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) {
+            return controller.waitForGate(flight, handle);
+        }
+        bool await_resume() const noexcept { return flight.gateAssigned != -1; }
+    };
+
+    // Returns true if the lifecycle must suspend until a gate is assigned
+    bool waitForGate(Flight& flight, std::coroutine_handle<> handle) {
+        if (!simulationRunning) return false;
+        return !gateAllocator->acquireOrWait(flight, simulationTimeMs(), handle);
+    }
+
+    // Free the flight's gate and hand it to the next compatible waiter
+    void releaseFlightGate(Flight& flight) {
+        if (flight.gateAssigned == -1) return;
+        std::coroutine_handle<> next = gateAllocator->release(flight, simulationTimeMs());
+        if (next) {
+            lifecycleExecutor->post(next);
+        }
+    }
+
+    std::chrono::seconds turnaroundTime(const Flight& flight) const {
+        return gateTurnaround[static_cast<int>(flight.aircraftType)];
+    }
+
+    void announceGateAssignment(const Flight& flight) {
+        SimEvent event = flightEvent(SimEventType::GateAssigned, flight);
+        event.resourceID = flight.gateAssigned;
+        events.publish(event);
+    }
+
+    void enqueueForRunway(Flight& flight, std::coroutine_handle<> handle) {
+        {
+            ProfiledLock lock(flightsMutex);
+            if (simulationRunning && flight.runwayAssigned == -1) {
+                flight.runwayWaiter = handle;
+                // Restored checkpoints may already have the flight queued
+                if (!flight.inRunwayQueue) {
+                    flight.inRunwayQueue = true;
+                    flight.queuedAt = std::chrono::steady_clock::now();
+                    runwayQueues.push(&flight);
+                }
+                publishStatus(flight);
+                requestDispatch();
+                return;
+            }
+        }
+        lifecycleExecutor->post(handle);
+    }
+
+    // Hand a queued flight back to the executor (caller holds flightsMutex)
+    void resumeRunwayWaiter(Flight& flight) {
+        if (flight.runwayWaiter) {
+            std::coroutine_handle<> handle = flight.runwayWaiter;
+            flight.runwayWaiter = nullptr;
+            lifecycleExecutor->post(handle);
+        }
+    }
+
+    // Start a flight lifecycle on the executor
+    void spawnLifecycle(Flight& flight) {
+        flightLifecycle(flight);
+    }
+
+    // Coroutine that manages a flight lifecycle; it only occupies a worker
+    // thread while it is actually doing work between phase delays. Each phase
+    // is timed from flight.phaseStart so a restored flight resumes mid-phase.
+    FlightTask flightLifecycle(Flight& flight) {
+        using namespace std::chrono;
+        LifecycleGuard guard(activeLifecycles);
+        co_await ExecutorHop{*lifecycleExecutor};
+        PhaseTraceGuard phaseTrace(flight);
+
+        bool isDeparture = (flight.direction == FlightDirection::EastDeparture ||
+                            flight.direction == FlightDirection::WestDeparture);
+
+        while (simulationRunning && !flight.hasFault && !flight.lifecycleComplete) {
+            switch (flight.phase) {
+                case FlightPhase::Holding:
+                    // Inbound medical and low-fuel emergencies have a runway held for them
+                    if (emergencyPolicy(flight.emergencyType).preempts) {
+                        ProfiledLock lock(flightsMutex);
+                        reserveRunway(flight, simulationTimeMs() +
+                                      duration_cast<milliseconds>(seconds(10) - phaseElapsed(flight)).count());
+                    }
+
+                    // Hold until the minimum hold is over and a runway is granted
+                    co_await phaseRemaining(flight, seconds(10));
+                    if (!simulationRunning) co_return;
+                    if (!co_await RunwayGrant{*this, flight}) co_return;
+
+                    flight.updatePhase(FlightPhase::Approach);
+                    flight.updateSpeed(400 + rand() % 201); // 400-600 km/h
+                    recordFlightState(flight);
+                    announcePhaseTransition(flight);
+                    checkSpeedViolation(flight);
+                    break;
+
+                case FlightPhase::Approach:
+                    co_await phaseRemaining(flight, kApproachTime);
+                    if (!simulationRunning) co_return;
+
+                    enterRunway(flight);
+                    flight.updatePhase(FlightPhase::Landing);
+                    flight.updateSpeed(240); // Start at max allowed landing speed
+                    recordFlightState(flight);
+                    announcePhaseTransition(flight);
+                    checkSpeedViolation(flight);
+                    break;
+
+                case FlightPhase::Landing:
+                    // Gradually decrease speed during landing
+                    while (phaseElapsed(flight) < kLandingRollTime) {
+                        co_await phaseDelay(seconds(1));
+                        if (!simulationRunning) co_return;
+                        auto elapsed = duration_cast<seconds>(phaseElapsed(flight)).count();
+                        if (elapsed < 6) {
+                            float landingProgress = elapsed / 6.0f; // 0 to 1
+                            flight.updateSpeed(240.0f * (1.0f - landingProgress) + 30.0f * landingProgress);
+                            recordFlightState(flight);
+                            checkSpeedViolation(flight);
                         }
                     }
-                    if (flight.runwayAssigned != -1) {
-                        releaseRunway(flight.runwayAssigned);
-                        flight.runwayAssigned = -1;
-                        
-                        {
-                            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                            std::cout << "\n=== RUNWAY RELEASED ===\n";
-                            std::cout << "Flight: #" << flight.flightNumber << "\n";
-                            std::cout << "Runway: " << flight.runwayAssigned << "\n";
-                            std::cout << "============================\n";
+
+                    // Runway exit: the taxi to the gate no longer blocks the runway
+                    releaseFlightRunway(flight);
+                    flight.updatePhase(FlightPhase::Taxi);
+                    flight.updateSpeed(20); // Safe taxi speed
+                    recordFlightState(flight);
+                    announcePhaseTransition(flight);
+                    break;
+
+                case FlightPhase::Taxi:
+                case FlightPhase::AtGate: {
+                    // Departures need a gate before boarding starts
+                    if (flight.phase == FlightPhase::AtGate && flight.gateAssigned == -1) {
+                        int64_t gateRequestedMs = simulationTimeMs();
+                        if (!co_await GateGrant{*this, flight}) co_return;
+                        flight.delayMs += simulationTimeMs() - gateRequestedMs;
+                        flight.updatePhase(FlightPhase::AtGate);
+                        announceGateAssignment(flight);
+                    }
+
+                    // Time to fault is drawn once per ground phase. The draw is
+                    // memoryless, so a restored flight draws again from now.
+                    auto groundTime = (flight.phase == FlightPhase::AtGate) ? turnaroundTime(flight)
+                                                                            : seconds(5);
+                    auto fault = groundFaults.sample(flight.aircraftType);
+                    auto faultAt = phaseElapsed(flight) + fault.after;
+                    if (faultAt < groundTime) {
+                        co_await phaseRemaining(flight, faultAt);
+                        if (!simulationRunning) co_return;
+                        reportGroundFault(flight, fault.kind);
+                        co_return;
+                    }
+                    co_await phaseRemaining(flight, groundTime);
+                    if (!simulationRunning) co_return;
+
+                    if (flight.phase == FlightPhase::AtGate) {
+                        releaseFlightGate(flight);
+                        if (isDeparture) {
+                            flight.updatePhase(FlightPhase::Taxi);
+                            flight.updateSpeed(15 + rand() % 16); // 15-30 km/h for taxiing
+                            recordFlightState(flight);
+                            announcePhaseTransition(flight);
+                        } else {
+                            // Turnaround at the gate ends the arrival's lifecycle
+                            flight.lifecycleComplete = true;
+                            publishStatus(flight);
                         }
+                    } else if (isDeparture) {
+                        if (!co_await RunwayGrant{*this, flight}) co_return;
+
+                        enterRunway(flight);
+                        flight.updatePhase(FlightPhase::TakeoffRoll);
+                        flight.updateSpeed(0.0f);
+                        recordFlightState(flight);
+                        announcePhaseTransition(flight);
+                    } else {
+                        // Arrivals hold at the end of the taxiway until a gate frees up
+                        int64_t gateRequestedMs = simulationTimeMs();
+                        if (!co_await GateGrant{*this, flight}) co_return;
+                        flight.delayMs += simulationTimeMs() - gateRequestedMs;
+                        announceGateAssignment(flight);
+
+                        flight.updatePhase(FlightPhase::AtGate);
+                        flight.updateSpeed(0.0f);
+                        recordFlightState(flight);
+                        announcePhaseTransition(flight, false);
                     }
                     break;
+                }
+
                 case FlightPhase::TakeoffRoll:
-                    if (elapsed >= 3) {
-                        flight.updatePhase(FlightPhase::Climb);
-                        flight.updateSpeed(250 + rand() % 213); // 250-463 km/h
-                        phaseStart = now;
-                        
-                        {
-                            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                            std::cout << "\n=== PHASE TRANSITION ===\n";
-                            std::cout << "Flight: #" << flight.flightNumber << "\n";
-                            std::cout << "New Phase: " << flight.getPhaseString() << "\n";
-                            std::cout << "Speed: " << flight.speed << " km/h\n";
-                            std::cout << "============================\n";
+                    // Gradually increase speed during takeoff roll
+                    while (phaseElapsed(flight) < kTakeoffRollTime) {
+                        co_await phaseDelay(seconds(1));
+                        if (!simulationRunning) co_return;
+                        auto elapsed = duration_cast<seconds>(phaseElapsed(flight)).count();
+                        if (elapsed < 3) {
+                            float rollProgress = static_cast<float>(elapsed) / 3.0f; // 0 to 1
+                            flight.updateSpeed(290.0f * rollProgress); // Up to 290 km/h
+                            recordFlightState(flight);
                         }
-                        
-                        // Check for speed violations in climb phase
-                        checkSpeedViolation(flight);
-                    } else {
-                        // Gradually increase speed during takeoff roll
-                        float rollProgress = static_cast<float>(elapsed) / 3.0f; // 0 to 1
-                        flight.updateSpeed(290.0f * rollProgress); // Up to 290 km/h
                     }
+
+                    // Liftoff clears the runway
+                    releaseFlightRunway(flight);
+                    flight.updatePhase(FlightPhase::Climb);
+                    flight.updateSpeed(250 + rand() % 213); // 250-463 km/h
+                    recordFlightState(flight);
+                    announcePhaseTransition(flight);
+                    checkSpeedViolation(flight);
                     break;
+
                 case FlightPhase::Climb:
-                    if (elapsed >= 4) {
-                        flight.updatePhase(FlightPhase::Cruise);
-                        flight.updateSpeed(800 + rand() % 101); // 800-900 km/h
-                        phaseStart = now;
+                    co_await phaseRemaining(flight, seconds(4));
+                    if (!simulationRunning) co_return;
+
+                    flight.updatePhase(FlightPhase::Cruise);
+                    flight.updateSpeed(800 + rand() % 101); // 800-900 km/h
+                    recordFlightState(flight);
+                    announcePhaseTransition(flight);
+                    checkSpeedViolation(flight);
+                    break;
+
+                case FlightPhase::Cruise:
+                    co_await phaseRemaining(flight, seconds(10));
+                    if (!simulationRunning) co_return;
+
+                    flight.updatePhase(FlightPhase::Departure);
+                    events.publish(flightEvent(SimEventType::FlightDeparted, flight));
+                    flight.lifecycleComplete = true;
+                    recordFlightState(flight);
+                    break;
+
+                case FlightPhase::Departure:
+                    flight.lifecycleComplete = true;
+                    break;
+            }
+        }
+    }
+
+    // Speed limits per phase; returns true and fills in the reason on a violation
+    static bool speedLimitViolation(FlightPhase phase, float speed, float& permissibleSpeed,
+                                    std::string& violationReason) {
+        bool violation = false;
+        permissibleSpeed = 0.0f;
+
+        switch (phase) {
+            case FlightPhase::Holding:
+                permissibleSpeed = 600.0f;
+                if (speed > 600.0f || speed < 400.0f) {
+                    violation = true;
+                    violationReason = "Speed outside holding range (400-600 km/h)";
+                }
+                break;
+            case FlightPhase::Approach:
+                permissibleSpeed = 290.0f;
+                if (speed < 240.0f || speed > 290.0f) {
+                    violation = true;
+                    violationReason = "Speed outside approach range (240-290 km/h)";
+                }
+                break;
+            case FlightPhase::Landing:
+                permissibleSpeed = 240.0f;
+                if (speed > 240.0f) {
+                    violation = true;
+                    violationReason = "Exceeded landing speed limit (240 km/h)";
+                }
+                break;
+            case FlightPhase::Taxi:
+                permissibleSpeed = 30.0f;
+                if (speed > 30.0f || speed < 15.0f) {
+                    violation = true;
+                    violationReason = "Speed outside taxi range (15-30 km/h)";
+                }
+                break;
+            case FlightPhase::AtGate:
+                permissibleSpeed = 5.0f;
+                if (speed > 5.0f) {
+                    violation = true;
+                    violationReason = "Exceeded gate speed limit (5 km/h)";
+                }
+                break;
+            case FlightPhase::TakeoffRoll:
+                permissibleSpeed = 290.0f;
+                if (speed > 290.0f) {
+                    violation = true;
+                    violationReason = "Exceeded takeoff roll speed limit (290 km/h)";
+                }
+                break;
+            case FlightPhase::Climb:
+                permissibleSpeed = 463.0f;
+                if (speed < 250.0f || speed > 463.0f) {
+                    violation = true;
+                    violationReason = "Speed outside climb range (250-463 km/h)";
+                }
+                break;
+            case FlightPhase::Cruise:
+                permissibleSpeed = 900.0f;
+                if (speed < 800.0f || speed > 900.0f) {
+                    violation = true;
+                    violationReason = "Speed outside cruise range (800-900 km/h)";
+                }
+                break;
+        }
+
+        return violation;
+    }
+
+    void checkSpeedViolation(Flight& flight) {
+        AllocScope allocScope(AllocSubsystem::Violations);
+        float permissibleSpeed = 0.0f;
+        std::string violationReason;
+        bool violation = speedLimitViolation(flight.phase, flight.speed, permissibleSpeed, violationReason);
+
+        if (violation && !flight.violationActive) {
+            flight.violationActive = true;
+            flight.violationReason = violationReason;
+
+            SimEvent event = flightEvent(SimEventType::SpeedViolation, flight);
+            event.limit = permissibleSpeed;
+            events.publish(event);
+            
+            // Generate AVN and store its ID
+            int avnID = issueAVN(flight, permissibleSpeed, ViolationKind::Speed);
+            if (avnID < 0) return;
+            {
+                ProfiledLock avnLock(avnMutex);
+                flight.avnIDs.push_back(avnID);
+            }
+            publishStatus(flight);
+        }
+    }
+
+    // Ground fault handling, called when a flight's scheduled fault comes due
+    void reportGroundFault(Flight& flight, GroundFault kind) {
+        AllocScope allocScope(AllocSubsystem::Faults);
+        if (flight.hasFault) return;
+        flight.hasFault = true;
+        flight.faultDescription = groundFaultName(kind);
+
+        SimEvent event = flightEvent(SimEventType::GroundFault, flight);
+        event.detail = static_cast<uint8_t>(kind);
+        events.publish(event);
+
+        // Remove from active queues
+        removeFaultedFlight(flight);
+        publishStatus(flight);
+    }
+
+    // Parse TYPE:KIND=RATE, where RATE is faults per simulated minute of
+    // ground time and TYPE or KIND may be "all"
+    bool configureGroundFaultRate(const std::string& spec) {
+        size_t colon = spec.find(':');
+        size_t equals = spec.find('=');
+        if (colon == std::string::npos || equals == std::string::npos || equals < colon) {
+            std::cerr << "Bad fault rate '" << spec << "', expected TYPE:KIND=PER_MINUTE\n";
+            return false;
+        }
+        std::string type = spec.substr(0, colon);
+        std::string kind = spec.substr(colon + 1, equals - colon - 1);
+        double perMinute = std::stod(spec.substr(equals + 1));
+
+        const std::pair<const char*, AircraftType> types[] = {
+            {"commercial", AircraftType::Commercial}, {"cargo", AircraftType::Cargo},
+            {"emergency", AircraftType::Emergency}};
+        const std::pair<const char*, GroundFault> kinds[] = {
+            {"brake", GroundFault::BrakeFailure}, {"hydraulic", GroundFault::HydraulicLeak},
+            {"apu", GroundFault::APUMalfunction}, {"steering", GroundFault::SteeringFault}};
+
+        bool matchedType = false;
+        bool matchedKind = false;
+        for (const auto& t : types) {
+            if (type != "all" && type != t.first) continue;
+            matchedType = true;
+            for (const auto& k : kinds) {
+                if (kind != "all" && kind != k.first) continue;
+                matchedKind = true;
+                groundFaults.setRate(t.second, k.second, perMinute / 60.0);
+            }
+        }
+        if (!matchedType || !matchedKind) {
+            std::cerr << "Unknown aircraft type or fault kind in '" << spec << "'\n";
+            return false;
+        }
+        return true;
+    }
+
+    // Reserve the AVN's ID and hand the record to the AVN writer, or to the
+    // AVN process in multi-process mode. Returns -1 if the AVN process could
+    // not take it; the ID is then left unused and must not be attached.
+    int issueAVN(Flight& flight, float permissibleSpeed, ViolationKind kind) {
+        AllocScope allocScope(AllocSubsystem::Violations);
+        int avnID = avnGenerator->reserveAVNID();
+        if (ipcPipeline && !ipcPipeline->submitViolation(flight, permissibleSpeed, kind, avnID)) {
+            return -1;
+        }
+        SimEvent event = flightEvent(SimEventType::AVNIssued, flight);
+        event.avnID = avnID;
+        event.detail = static_cast<uint8_t>(kind);
+        event.limit = permissibleSpeed;
+        events.publish(event);
+        return avnID;
+    }
+
+    // Airborne phases tracked by the separation monitor
+    static bool isAirborne(FlightPhase phase) {
+        return phase == FlightPhase::Holding || phase == FlightPhase::Approach ||
+               phase == FlightPhase::Landing || phase == FlightPhase::Climb ||
+               phase == FlightPhase::Cruise;
+    }
+
+    // Place a flight the first time it is seen airborne. Positions are derived
+    // from phase and direction, so restored flights get a fresh position too.
+    void placeFlight(Flight& flight, FlightPhase phase, std::mt19937& gen) {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const float pi = 3.14159265f;
+        float bearing;
+        float range;
+
+        switch (flight.direction) {
+            case FlightDirection::NorthArrival: bearing = pi / 2; break;
+            case FlightDirection::SouthArrival: bearing = -pi / 2; break;
+            case FlightDirection::EastDeparture: bearing = 0.0f; break;
+            default: bearing = pi; break;
+        }
+
+        switch (phase) {
+            case FlightPhase::Holding:
+                // Stacks spread over 80 degrees either side of the inbound bearing
+                bearing += (unit(gen) - 0.5f) * (80.0f * pi / 180.0f) * 2.0f;
+                range = 40.0f + unit(gen) * 40.0f;
+                flight.altitude = 3000.0f + SeparationMonitor::kVerticalMinimumM * static_cast<float>(gen() % 10);
+                break;
+            case FlightPhase::Approach:
+                range = 25.0f;
+                flight.altitude = 1500.0f;
+                break;
+            case FlightPhase::Landing:
+                range = 8.0f;
+                flight.altitude = 500.0f;
+                break;
+            case FlightPhase::Climb:
+                range = 3.0f;
+                flight.altitude = 500.0f;
+                break;
+            default:
+                range = 30.0f;
+                flight.altitude = 10000.0f;
+                break;
+        }
+
+        flight.posX = range * std::cos(bearing);
+        flight.posY = range * std::sin(bearing);
+        flight.heading = (phase == FlightPhase::Climb || phase == FlightPhase::Cruise)
+                             ? bearing : bearing + pi;
+        flight.positioned = true;
+    }
+
+    // Advance a flight by dt seconds according to its phase
+    void moveFlight(Flight& flight, FlightPhase phase, float speed, float dt) {
+        const float pi = 3.14159265f;
+        float speedKmS = std::max(speed, 0.0f) / 3600.0f;
+
+        switch (phase) {
+            case FlightPhase::Holding: {
+                // Orbit with a 5 km radius; lifecycles do not set a holding speed
+                if (speedKmS <= 0.0f) speedKmS = 450.0f / 3600.0f;
+                flight.heading += speedKmS * dt / 5.0f;
+                break;
+            }
+            case FlightPhase::Approach:
+            case FlightPhase::Landing: {
+                // Head for the threshold and descend towards it
+                float range = std::sqrt(flight.posX * flight.posX + flight.posY * flight.posY);
+                flight.heading = std::atan2(-flight.posY, -flight.posX);
+                float step = std::min(speedKmS * dt, range);
+                if (range > 0.0f) {
+                    flight.altitude -= flight.altitude * (step / range);
+                }
+                break;
+            }
+            case FlightPhase::Climb:
+                flight.altitude = std::min(flight.altitude + 15.0f * dt, 10000.0f);
+                break;
+            case FlightPhase::Cruise:
+                flight.altitude = std::min(flight.altitude + 10.0f * dt, 11000.0f);
+                break;
+            default:
+                return;
+        }
+
+        if (flight.heading > pi) flight.heading -= 2 * pi;
+        if (flight.heading < -pi) flight.heading += 2 * pi;
+        flight.posX += speedKmS * dt * std::cos(flight.heading);
+        flight.posY += speedKmS * dt * std::sin(flight.heading);
+    }
+
+    // Issue an AVN for a loss of separation. The lower-priority flight is
+    // fined; between equals, the later-scheduled one.
+    void reportSeparationConflict(const SeparationMonitor::Conflict& conflict) {
+        Flight* offender = conflict.second;
+        Flight* other = conflict.first;
+        if (conflict.first->priorityLevel > conflict.second->priorityLevel ||
+            (conflict.first->priorityLevel == conflict.second->priorityLevel &&
+             conflict.first->scheduledTime > conflict.second->scheduledTime)) {
+            std::swap(offender, other);
+        }
+
+        SimEvent event = flightEvent(SimEventType::SeparationConflict, *offender);
+        event.otherFlight = other->flightNumber;
+        event.otherAirline = other->airline;
+        event.lateralKm = conflict.lateralKm;
+        event.verticalM = conflict.verticalM;
+        events.publish(event);
+
+        int avnID = issueAVN(*offender, 0.0f, ViolationKind::Separation);
+        if (avnID < 0) return;
+        {
+            ProfiledLock avnLock(avnMutex);
+            offender->avnIDs.push_back(avnID);
+        }
+        publishAVNs(*offender);
+    }
+
+    // Airspace thread: advances airborne positions once per simulated second
+    // and checks separation. New flights are picked up from the end of the
+    // flight list, so each tick only copies what was added since the last one.
+    void airspaceThread() {
+        using namespace std::chrono;
+        g_tracer.nameThread("airspace");
+        AllocTracker::tagThread(AllocSubsystem::Airspace);
+        std::mt19937 gen(std::random_device{}());
+        std::vector<Flight*> tracked;
+        std::vector<Flight*> airborne;
+        size_t seen = 0;
+        const float dt = 1.0f;
+
+        while (simulationRunning) {
+            std::this_thread::sleep_for(toWallTime(seconds(1)));
+            if (!simulationRunning) break;
+
+            {
+                ProfiledLock lock(flightsMutex);
+                for (; seen < flights.size(); seen++) {
+                    tracked.push_back(flights[seen].get());
+                }
+            }
+
+            airborne.clear();
+            size_t kept = 0;
+            for (Flight* flight : tracked) {
+                // Lifecycles own these fields; one relaxed snapshot per tick.
+                // Position fields belong to this thread alone.
+                if (flight->lifecycleComplete.load(std::memory_order_relaxed) ||
+                    flight->hasFault.load(std::memory_order_relaxed)) continue;
+                tracked[kept++] = flight;
+
+                FlightPhase phase = flight->phase.load(std::memory_order_relaxed);
+                if (!isAirborne(phase)) {
+                    flight->positioned = false;
+                    continue;
+                }
+                if (!flight->positioned) {
+                    placeFlight(*flight, phase, gen);
+                } else {
+                    moveFlight(*flight, phase, flight->speed.load(std::memory_order_relaxed), dt);
+                }
+                airborne.push_back(flight);
+            }
+            tracked.resize(kept);
+            airborneCount = airborne.size();
+
+            for (const auto& conflict : separationMonitor.update(airborne)) {
+                reportSeparationConflict(conflict);
+            }
+            activeConflicts = separationMonitor.activeConflicts();
+            totalConflicts = separationMonitor.totalConflicts();
+        }
+    }
+
+    void removeFaultedFlight(Flight& flight) {
+        ProfiledLock lock(flightsMutex);
+        // Remove from runway queue if present
+        if (flight.inRunwayQueue) {
+            runwayQueues.remove(flight);
+            flight.inRunwayQueue = false;
+        }
+        cancelReservation(flight);
+        
+        // Release runway if assigned
+        if (flight.runwayAssigned != -1) {
+            releaseRunway(flight);
+            flight.runwayAssigned = -1;
+        }
+        
+        // Tow the aircraft off its gate
+        releaseFlightGate(flight);
+    }
+
+    // Runway management functions
+    // Grant a flight the runway's next slot; it occupies the runway only
+    // once it enters it. Caller holds flightsMutex.
+    void assignRunway(Flight& flight, int runwayID) {
+        flight.runwayAssigned = runwayID;
+
+        SimEvent event = flightEvent(SimEventType::RunwayGranted, flight);
+        event.resourceID = runwayID;
+        event.detail = RunwayQueues::classFor(flight) != runways[runwayID]->homeClass;
+        events.publish(event);
+    }
+
+    // Touchdown or start of the takeoff roll on the granted runway
+    void enterRunway(Flight& flight) {
+        if (flight.runwayAssigned == -1) return;
+        Runway& runway = *runways[flight.runwayAssigned];
+        ProfiledLock lock(runway.runwayMutex);
+        runway.occupied.store(true);
+        sharedRunwayStatus->occupiedMask.fetch_or(RunwayMask{1} << runway.id);
+        flight.runwayOccupied = true;
+        flight.runwayUsed = runway.id;
+        flight.runwayEnterMs = simulationTimeMs();
+        etaModel->onEnter(runway.id, RunwayQueues::classFor(flight), flight.runwayEnterMs);
+        g_tracer.asyncBegin(runway.name.c_str(), "runway", runway.id, flight.flightNumber);
+    }
+
+    // How long before its runway use a flight is granted: arrivals fly the
+    // approach first, departures start rolling at once
+    static int64_t runwayLeadMs(FlightDirection direction) {
+        bool isArrival = direction == FlightDirection::NorthArrival || direction == FlightDirection::SouthArrival;
+        return isArrival ? std::chrono::duration_cast<std::chrono::milliseconds>(kApproachTime).count() : 0;
+    }
+
+    static int64_t runwayLeadMs(const Flight& flight) {
+        return runwayLeadMs(flight.direction);
+    }
+
+    // Lead plus runway use plus separation buffer
+    int64_t runwaySlotMs(const Flight& flight) const {
+        bool isArrival = runwayLeadMs(flight) > 0;
+        auto use = isArrival ? kLandingRollTime : kTakeoffRollTime;
+        return runwayLeadMs(flight) + std::chrono::duration_cast<std::chrono::milliseconds>(use).count() +
+               separationBufferMs[static_cast<int>(RunwayQueues::classFor(flight))];
+    }
+
+    // Parse CLASS=MS for --runway-buffer; CLASS is arrival, departure or cargo
+    bool configureRunwayBuffer(const std::string& spec) {
+        size_t equals = spec.find('=');
+        std::string name = spec.substr(0, equals);
+        const std::pair<const char*, RunwayClass> classes[] = {
+            {"arrival", RunwayClass::Arrival}, {"departure", RunwayClass::Departure},
+            {"cargo", RunwayClass::CargoEmergency}};
+        for (const auto& entry : classes) {
+            if (equals == std::string::npos || name != entry.first) continue;
+            int c = static_cast<int>(entry.second);
+            separationBufferMs[c] = std::max<int64_t>(0, std::stoll(spec.substr(equals + 1)));
+            int64_t useMs = entry.second == RunwayClass::Departure ? 3000
+                          : entry.second == RunwayClass::Arrival ? 6000 : 4500;
+            etaModel->seedHold(entry.second, useMs + separationBufferMs[c]);
+            return true;
+        }
+        std::cerr << "Bad runway buffer '" << spec << "', expected arrival|departure|cargo=MS\n";
+        return false;
+    }
+
+    // Simulated milliseconds until a queued flight is expected to be granted a
+    // runway; 0 if it is not queued. O(log n) for the rank lookup, O(1) when
+    // the caller already knows the rank. Caller holds flightsMutex.
+    int64_t expectedRunwayWaitMs(const Flight& flight, int64_t rank = -1) {
+        if (!flight.inRunwayQueue) return 0;
+        if (rank < 0) rank = runwayQueues.rank(flight);
+        return runwayWaitMs(RunwayQueues::classFor(flight), runwayLeadMs(flight), rank);
+    }
+
+    // The same estimate for a status snapshot, taken when queried so it
+    // follows grants, insertions ahead and the learned slot lengths. Reads
+    // only atomics and the queue's shared lock, never flightsMutex. -1 if
+    // the flight is not queued.
+    int64_t expectedRunwayWaitMs(const FlightStatus& status) {
+        if (!status.inRunwayQueue) return -1;
+        int64_t rank = runwayQueues.rank(status);
+        if (rank < 0) return 0;  // Granted since the snapshot
+        return runwayWaitMs(RunwayQueues::classFor(status.aircraftType, status.direction),
+                            runwayLeadMs(status.direction), rank);
+    }
+
+    // Wait for a flight with the given lead and rank in its class queue: the
+    // class's first free runway, then one mean slot per flight ahead
+    int64_t runwayWaitMs(RunwayClass runwayClass, int64_t leadMs, int64_t rank) {
+        int64_t now = simulationTimeMs();
+        int servers;
+        int64_t grantAt = std::max(now, classFreeAtMs(runwayClass, servers) - leadMs);
+        return grantAt - now + rank * etaModel->meanHoldMs(runwayClass) / servers;
+    }
+
+    // Earliest a runway serving the class first frees up, with how many such
+    // runways share its queue; any capable runway counts if none is home to it
+    int64_t classFreeAtMs(RunwayClass runwayClass, int& servers) const {
+        int c = static_cast<int>(runwayClass);
+        RunwayMask serving = runwayMasks.home[c] ? runwayMasks.home[c] : runwayMasks.capable[c];
+        servers = std::popcount(serving);
+        int64_t freeAt = std::numeric_limits<int64_t>::max();
+        for (; serving; serving &= serving - 1) {
+            freeAt = std::min(freeAt, etaModel->freeAtMs(std::countr_zero(serving)));
+        }
+        return freeAt;
+    }
+
+    // Portal query: runway ETAs for an airline's queued flights. Walks the
+    // runway queues only, and prints after flightsMutex is released.
+    void printRunwayETAs(const std::string& airlineName) {
+        std::ostringstream lines;
+        bool found = false;
+        {
+            ProfiledLock lock(flightsMutex);
+            runwayQueues.forEach([&](const Flight& flight, int64_t rank) {
+                if (flight.airline->name != airlineName) return;
+                found = true;
+                lines << "Flight #" << flight.flightNumber << " (" << flight.getPhaseString() << "): "
+                      << "position " << rank + 1
+                      << ", runway expected in " << expectedRunwayWaitMs(flight, rank) / 1000 << "s\n";
+            });
+        }
+        ProfiledLock consoleLock(g_console_mutex);
+        std::cout << "\n=== RUNWAY ETA: " << airlineName << " ===\n";
+        std::cout << (found ? lines.str() : "No flights waiting for a runway\n");
+        std::cout << "============================\n";
+    }
+
+    // Portal query: one flight's status from the index, without flightsMutex
+    void printFlightStatus(int flightNumber) {
+        FlightStatus status;
+        bool found = flightStatus(flightNumber, status);
+        int64_t waitMs = found ? expectedRunwayWaitMs(status) : -1;
+
+        ProfiledLock consoleLock(g_console_mutex);
+        std::cout << "\n=== FLIGHT STATUS ===\n";
+        if (!found) {
+            std::cout << "Flight #" << flightNumber << " not found\n";
+            std::cout << "============================\n";
+            return;
+        }
+        std::cout << "Flight: #" << status.flightNumber << " (" << status.airline->name << ")\n";
+        std::cout << "Phase: " << kFlightPhaseNames[static_cast<int>(status.phase)]
+                  << (status.complete ? " (complete)" : "") << "\n";
+        std::cout << "Speed: " << status.speed << " km/h\n";
+        if (status.runwayAssigned != -1) {
+            std::cout << "Runway: " << runways[status.runwayAssigned]->name
+                      << (status.runwayOccupied ? " (on runway)" : " (granted)") << "\n";
+        } else if (status.inRunwayQueue) {
+            std::cout << "Runway: queued, expected in "
+                      << waitMs / 1000 << "s\n";
+        }
+        if (status.gateAssigned != -1) {
+            std::cout << "Gate: " << gateAllocator->allGates()[status.gateAssigned].name << "\n";
+        }
+        if (status.faulted) {
+            std::cout << "Fault: " << status.faultDescription << "\n";
+        }
+        std::cout << "AVNs:";
+        for (int avnID : status.avnIDs) {
+            std::cout << " #" << avnID;
+        }
+        std::cout << (status.avnIDs.empty() ? " none\n" : "\n");
+        std::cout << "============================\n";
+    }
+
+    // Head of a class queue, after waking flights that already hold a runway
+    // (caller holds flightsMutex)
+    Flight* queueHead(RunwayClass runwayClass) {
+        while (!runwayQueues.empty(runwayClass)) {
+            Flight* flight = runwayQueues.top(runwayClass);
+            if (flight->runwayAssigned == -1) {
+                return flight;
+            }
+            runwayQueues.pop(runwayClass);
+            flight->inRunwayQueue = false;
+            resumeRunwayWaiter(*flight);
+        }
+        return nullptr;
+    }
+
+    // Dispatch order between queue heads
+    static bool runwayPriorityBefore(const Flight* a, const Flight* b) {
+        if (a->priorityLevel != b->priorityLevel) {
+            return a->priorityLevel < b->priorityLevel;
+        }
+        return a->scheduledTime < b->scheduledTime;
+    }
+
+    using QueueHeads = std::array<std::pair<Flight*, RunwayClass>, kRunwayClassCount>;
+
+    // Put the first count heads in dispatch order. There is at most one per
+    // class, so an insertion sort is enough.
+    static void sortQueueHeads(QueueHeads& heads, size_t count) {
+        for (size_t i = 1; i < count; i++) {
+            for (size_t j = i; j > 0 && runwayPriorityBefore(heads[j].first, heads[j - 1].first); j--) {
+                std::swap(heads[j], heads[j - 1]);
+            }
+        }
+    }
+
+    // Runways a flight may be granted now: those capable of its class, less
+    // any held for an emergency that it would not clear in time. The layout
+    // and reservations are parameters so capacity scenarios share the policy.
+    RunwayMask allowedRunways(const Flight& flight, RunwayClass runwayClass, int64_t nowMs,
+                              const RunwayClassMasks& masks, RunwayMask reserved,
+                              const std::vector<RunwayReservation>& held) const {
+        RunwayMask allowed = masks.capable[static_cast<int>(runwayClass)];
+        if (emergencyPolicy(flight.emergencyType).preempts) return allowed;
+        for (RunwayMask blocked = reserved & allowed; blocked; blocked &= blocked - 1) {
+            int runwayID = std::countr_zero(blocked);
+            const RunwayReservation& reservation = held[runwayID];
+            if (reservation.flight != &flight &&
+                nowMs + runwaySlotMs(flight) > reservation.dueMs + runwayLeadMs(*reservation.flight)) {
+                allowed &= ~(RunwayMask{1} << runwayID);
+            }
+        }
+        return allowed;
+    }
+
+    // Caller holds flightsMutex
+    RunwayMask allowedRunways(const Flight& flight, RunwayClass runwayClass, int64_t nowMs) const {
+        return allowedRunways(flight, runwayClass, nowMs, runwayMasks, reservedRunways, reservations);
+    }
+
+    // First runway among `allowed` that is clear by the flight's touchdown or
+    // roll. Free runways come first, then runways whose current slot ends in
+    // time; within each, runways that serve the class first. Each step is a
+    // mask AND and a find-first-set. freeAtMs(runwayID) is the runway's next
+    // slot start.
+    template <typename FreeAt>
+    static int pickRunway(const Flight& flight, RunwayMask allowed, RunwayMask free, RunwayMask home,
+                          int64_t nowMs, FreeAt freeAtMs) {
+        int64_t clearBy = nowMs + runwayLeadMs(flight);
+        const RunwayMask tiers[] = {allowed & free & home, allowed & free & ~home,
+                                    allowed & ~free & home, allowed & ~free & ~home};
+        for (RunwayMask candidates : tiers) {
+            for (; candidates; candidates &= candidates - 1) {
+                int runwayID = std::countr_zero(candidates);
+                if (freeAtMs(runwayID) <= clearBy) return runwayID;
+            }
+        }
+        return -1;
+    }
+
+    int pickRunway(const Flight& flight, RunwayClass runwayClass, RunwayMask allowed, int64_t nowMs) const {
+        return pickRunway(flight, allowed, freeRunways.load(std::memory_order_relaxed),
+                          runwayMasks.home[static_cast<int>(runwayClass)], nowMs,
+                          [this](int runwayID) { return etaModel->freeAtMs(runwayID); });
+    }
+
+    // Grant runways to queue heads, best first, until no head can be placed.
+    // Caller holds flightsMutex.
+    void dispatchRunways() {
+        using namespace std::chrono;
+        int64_t nowMs = simulationTimeMs();
+
+        while (true) {
+            QueueHeads heads;
+            size_t headCount = 0;
+            for (int c = 0; c < kRunwayClassCount; c++) {
+                RunwayClass runwayClass = static_cast<RunwayClass>(c);
+                if (Flight* head = queueHead(runwayClass)) {
+                    heads[headCount++] = {head, runwayClass};
+                }
+            }
+            sortQueueHeads(heads, headCount);
+
+            Flight* best = nullptr;
+            RunwayClass bestClass = RunwayClass::Arrival;
+            int runwayID = -1;
+            for (size_t i = 0; i < headCount && runwayID < 0; i++) {
+                auto [flight, runwayClass] = heads[i];
+                runwayID = pickRunway(*flight, runwayClass, allowedRunways(*flight, runwayClass, nowMs), nowMs);
+                best = flight;
+                bestClass = runwayClass;
+            }
+            if (runwayID < 0) return;
+
+            assignRunway(*best, runwayID);
+            runwayQueues.pop(bestClass);
+            etaModel->onGrant(runwayID, nowMs + runwaySlotMs(*best));
+            runwayGrantsOutstanding[runwayID]++;
+            freeRunways.fetch_and(~(RunwayMask{1} << runwayID));
+            cancelReservation(*best);
+            best->inRunwayQueue = false;
+            runwayGrants++;
+            int64_t waitMs = duration_cast<milliseconds>(toSimTime(steady_clock::now() - best->queuedAt)).count();
+            runwayWaitTotalMs += waitMs;
+            best->delayMs += waitMs;
+            recordEmergencyGrant(*best, waitMs);
+            publishStatus(*best);
+            resumeRunwayWaiter(*best);
+        }
+    }
+
+    // Runway in `open` whose next slot starts first, -1 if none
+    template <typename FreeAt>
+    static int earliestFreeRunway(RunwayMask open, FreeAt freeAtMs) {
+        int chosen = -1;
+        for (; open; open &= open - 1) {
+            int runwayID = std::countr_zero(open);
+            if (chosen == -1 || freeAtMs(runwayID) < freeAtMs(chosen)) {
+                chosen = runwayID;
+            }
+        }
+        return chosen;
+    }
+
+    // Hold a runway for an inbound emergency, preferring the one expected to
+    // free first. Caller holds flightsMutex.
+    void reserveRunway(Flight& flight, int64_t dueMs) {
+        if (flight.reservedRunway != -1 || flight.runwayAssigned != -1) return;
+        RunwayMask open = runwayMasks.capable[static_cast<int>(RunwayQueues::classFor(flight))] & ~reservedRunways;
+        int chosen = earliestFreeRunway(open, [this](int runwayID) { return etaModel->freeAtMs(runwayID); });
+        if (chosen == -1) return;  // Every capable runway is already held for an emergency
+
+        reservations[chosen] = {&flight, dueMs};
+        reservedRunways |= RunwayMask{1} << chosen;
+        flight.reservedRunway = chosen;
+
+        SimEvent event = flightEvent(SimEventType::RunwayReserved, flight);
+        event.resourceID = chosen;
+        events.publish(event);
+    }
+
+    // Caller holds flightsMutex
+    void cancelReservation(Flight& flight) {
+        if (flight.reservedRunway == -1) return;
+        reservations[flight.reservedRunway] = RunwayReservation{};
+        reservedRunways &= ~(RunwayMask{1} << flight.reservedRunway);
+        flight.reservedRunway = -1;
+    }
+
+    // Caller holds flightsMutex
+    void recordEmergencyGrant(const Flight& flight, int64_t waitMs) {
+        if (flight.emergencyType == EmergencyType::None) return;
+        int type = static_cast<int>(flight.emergencyType);
+        emergencyGrantMs[type].push_back(waitMs);
+        int64_t sloMs = emergencyPolicy(flight.emergencyType).grantSloMs;
+        if (sloMs > 0 && waitMs > sloMs) {
+            emergencySloMisses[type]++;
+        }
+    }
+
+    // Note that the dispatcher has work; only the oldest pending request counts
+    void requestDispatch() {
+        int64_t expected = 0;
+        dispatchRequestNs.compare_exchange_strong(expected, monotonicNs(), std::memory_order_relaxed);
+    }
+
+    // Runway exit; the runway stays clear for the movement's separation buffer.
+    // Caller holds flightsMutex.
+    void releaseRunway(Flight& flight) {
+        int runwayID = flight.runwayAssigned;
+        if (runwayID >= 0 && runwayID < runways.size()) {
+            if (flight.runwayOccupied) flight.runwayExitMs = simulationTimeMs();
+            RunwayClass movementClass = RunwayQueues::classFor(flight);
+            {
+                ProfiledLock lock(runways[runwayID]->runwayMutex);
+                runways[runwayID]->occupied.store(false);
+                etaModel->onRelease(runwayID, simulationTimeMs(), separationBufferMs[static_cast<int>(movementClass)]);
+            }
+            RunwayMask bit = RunwayMask{1} << runwayID;
+            sharedRunwayStatus->occupiedMask.fetch_and(~bit);
+            if (runwayGrantsOutstanding[runwayID] > 0 && --runwayGrantsOutstanding[runwayID] == 0) {
+                freeRunways.fetch_or(bit);
+            }
+            runwayMovements++;
+            requestDispatch();
+            g_tracer.asyncEnd(runways[runwayID]->name.c_str(), "runway", runwayID);
+
+            SimEvent event = flightEvent(SimEventType::RunwayReleased, flight);
+            event.resourceID = runwayID;
+            events.publish(event);
+        }
+    }
+
+    // Simulated time until schedule i spawns its next flight or burst. With
+    // an offered rate set, traffic is split across schedules by their usual
+    // frequency; bursts arrive less often so the mean flight rate holds.
+    std::chrono::steady_clock::duration nextArrivalInterval(size_t i, std::mt19937& gen) {
+        using namespace std::chrono;
+        double rate = offeredRatePerHour.load();
+        if (rate <= 0.0 && arrivalProcess == ArrivalProcess::Scheduled) {
+            return seconds(flightSchedules[i].intervalSeconds);
+        }
+
+        double meanSeconds = rate > 0.0 ? 3600.0 / (rate * scheduleShare[i])
+                                        : static_cast<double>(flightSchedules[i].intervalSeconds);
+        if (arrivalProcess == ArrivalProcess::Bursty) {
+            meanSeconds *= meanBurstSize;
+        }
+        std::exponential_distribution<> interArrival(1.0 / meanSeconds);
+        return duration_cast<steady_clock::duration>(duration<double>(interArrival(gen)));
+    }
+
+    // Flights spawned together at one arrival instant
+    size_t nextBurstSize(std::mt19937& gen) const {
+        if (arrivalProcess != ArrivalProcess::Bursty || meanBurstSize <= 1.0) return 1;
+        return 1 + std::geometric_distribution<size_t>(1.0 / meanBurstSize)(gen);
+    }
+
+    void buildCandidateTables() {
+        candidateTables.assign(flightSchedules.size(), {});
+        scheduleShare.assign(flightSchedules.size(), 0.0);
+
+        double totalFrequency = 0.0;
+        for (const auto& schedule : flightSchedules) {
+            totalFrequency += 1.0 / schedule.intervalSeconds;
+        }
+
+        for (size_t i = 0; i < flightSchedules.size(); i++) {
+            const auto& schedule = flightSchedules[i];
+            scheduleShare[i] = (1.0 / schedule.intervalSeconds) / totalFrequency;
+
+            // Military and medical emergencies go to their specialist airline;
+            // other emergencies to any emergency airline
+            bool needsSpecialist = std::any_of(airlines.begin(), airlines.end(), [&](const Airline& airline) {
+                return airline.specialty == schedule.emergencyType;
+            });
+            for (size_t j = 0; j < airlines.size(); j++) {
+                if (airlines[j].type != AircraftType::Emergency) {
+                    candidateTables[i][0].push_back(j);
+                } else if (!needsSpecialist || airlines[j].specialty == schedule.emergencyType) {
+                    candidateTables[i][1].push_back(j);
+                }
+            }
+        }
+    }
+
+    // Airlines eligible to fly a schedule's next flight
+    const std::vector<size_t>& airlineCandidates(size_t schedule, bool isEmergency) const {
+        return candidateTables[schedule][isEmergency ? 1 : 0];
+    }
+
+    // Choose how flights are spaced; call before startSimulation
+    void configureArrivals(ArrivalProcess process, double ratePerHour, double burstSize) {
+        arrivalProcess = process;
+        meanBurstSize = std::max(1.0, burstSize);
+        if (ratePerHour > 0.0) {
+            offeredRatePerHour = ratePerHour;
+        }
+    }
+
+    // Change the offered arrival rate while running; 0 restores the schedules
+    void setOfferedRate(double ratePerHour) {
+        offeredRatePerHour = std::max(0.0, ratePerHour);
+    }
+
+    // Add one flight outside the schedules; returns its number, -1 if the
+    // airline is unknown or -2 if the simulation is not running
+    int injectFlight(const std::string& airlineName, FlightDirection direction, EmergencyType emType) {
+        auto airline = std::find_if(airlines.begin(), airlines.end(), [&](const Airline& candidate) {
+            return candidate.name == airlineName;
+        });
+        if (airline == airlines.end()) return -1;
+        if (!simulationRunning) return -2;
+
+        int number = flightNumberCounter++;
+        auto flight = std::make_unique<Flight>(number, &*airline, airline->type, direction,
+                                               std::chrono::system_clock::now(), emType);
+        if (direction == FlightDirection::EastDeparture || direction == FlightDirection::WestDeparture) {
+            flight->updatePhase(FlightPhase::AtGate);
+        }
+        return addFlight(std::move(flight)) ? number : -2;
+    }
+
+    // Flight numbers handed out so far, restored ones included
+    unsigned int flightNumbersIssued() const { return flightNumberCounter.load(); }
+
+    struct Status {
+        bool running;
+        int64_t simulationMs;
+        size_t flights;
+        size_t airborne;
+        size_t queued[kRunwayClassCount];
+        uint64_t grants;
+        uint64_t movements;
+        double offeredRatePerHour;
+    };
+
+    // Counters only, so a client polling status never takes flightsMutex.
+    // Live flights are those whose lifecycle is still running.
+    Status status() {
+        Status result{};
+        result.running = simulationRunning.load();
+        result.simulationMs = result.running ? simulationTimeMs() : 0;
+        result.flights = static_cast<size_t>(std::max(0, activeLifecycles.load()));
+        result.airborne = airborneCount.load();
+        for (int c = 0; c < kRunwayClassCount; c++) {
+            result.queued[c] = runwayQueues.size(static_cast<RunwayClass>(c));
+        }
+        result.grants = runwayGrants.load();
+        result.movements = runwayMovements.load();
+        result.offeredRatePerHour = offeredRatePerHour.load();
+        return result;
+    }
+
+    // End the run early, as if the simulated time had run out
+    void stopSimulation() {
+        flightGenerationRunning = false;
+        simulationRunning = false;
+    }
+
+    // Flight generation thread function. Each wake-up spawns every flight
+    // that has come due, in one batch under one lock, then sleeps until the
+    // next arrival.
+    void flightGenerationThread() {
+        using namespace std::chrono;
+        g_tracer.nameThread("flight-generator");
+        AllocTracker::tagThread(AllocSubsystem::Generator);
+        constexpr size_t kMaxSpawnBatch = 1024;
+        auto startTime = steady_clock::now();
+        
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_real_distribution<> dis(0.0, 1.0);
+        
+        std::vector<steady_clock::time_point> due;
+        {
+            // Restored checkpoints keep their schedule positions
+            ProfiledLock lock(flightsMutex);
+            if (nextFlightTimes.size() != flightSchedules.size()) {
+                nextFlightTimes.assign(flightSchedules.size(), startTime);
+            }
+            due = nextFlightTimes;
+        }
+        
+        std::vector<std::unique_ptr<Flight>> batch;
+        std::vector<Flight*> spawned;
+        batch.reserve(kMaxSpawnBatch);
+        spawned.reserve(kMaxSpawnBatch);
+        
+        flightGenerationRunning = true;
+        
+        while (flightGenerationRunning) {
+            auto now = steady_clock::now();
+            bool advanced = false;
+            
+            // Collect every flight that is due on each schedule
+            for (size_t i = 0; i < flightSchedules.size(); i++) {
+                const auto& schedule = flightSchedules[i];
+                
+                while (now >= due[i] && batch.size() < kMaxSpawnBatch) {
+                    for (size_t n = nextBurstSize(gen); n > 0 && batch.size() < kMaxSpawnBatch; n--) {
+                        bool isEmergency = (dis(gen) < schedule.emergencyProbability);
                         
-                        {
-                            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                            std::cout << "\n=== PHASE TRANSITION ===\n";
-                            std::cout << "Flight: #" << flight.flightNumber << "\n";
-                            std::cout << "New Phase: " << flight.getPhaseString() << "\n";
-                            std::cout << "Speed: " << flight.speed << " km/h\n";
-                            std::cout << "============================\n";
-                        }
+                        const std::vector<size_t>& candidateAirlines = airlineCandidates(i, isEmergency);
+                        if (candidateAirlines.empty()) continue;
                         
-                        // Check for speed violations in cruise phase
-                        checkSpeedViolation(flight);
+                        Airline& airline = airlines[candidateAirlines[dis(gen) * candidateAirlines.size()]];
+                        EmergencyType emType = isEmergency ? schedule.emergencyType : EmergencyType::None;
                         
-                        // Release runway after aircraft has climbed
-                        if (flight.runwayAssigned != -1) {
-                            releaseRunway(flight.runwayAssigned);
-                            flight.runwayAssigned = -1;
-                            
-                            {
-                                std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                                std::cout << "\n=== RUNWAY RELEASED ===\n";
-                                std::cout << "Flight: #" << flight.flightNumber << "\n";
-                                std::cout << "Runway: " << flight.runwayAssigned << "\n";
-                                std::cout << "============================\n";
-                            }
+                        batch.push_back(std::make_unique<Flight>(flightNumberCounter++, &airline,
+                                                                 airline.type,
+                                                                 schedule.direction,
+                                                                 system_clock::now(),
+                                                                 emType));
+                        if (schedule.direction == FlightDirection::EastDeparture ||
+                            schedule.direction == FlightDirection::WestDeparture) {
+                            batch.back()->updatePhase(FlightPhase::AtGate);
                         }
                     }
-                    break;
-                case FlightPhase::Cruise:
-                    if (elapsed >= 10) {
-                        flight.updatePhase(FlightPhase::Departure);
-                        std::cout << "Flight #" << flight.flightNumber << " departed from airspace." << std::endl;
-                        // Flight has left the controlled airspace, end its simulation
-                        return;
-                    }
-                    break;
-                case FlightPhase::Departure:
-                    {
-                        std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                        std::cout << "Flight #" << flight.flightNumber << " departed from airspace.\n";
-                        std::cout << "============================\n";
+                    
+                    // Step from the previous arrival so the rate is not capped by
+                    // how often this thread wakes, but drop backlog over a second old
+                    due[i] = std::max(due[i], now - toWallTime(seconds(1))) + toWallTime(nextArrivalInterval(i, gen));
+                    advanced = true;
+                }
+            }
+            
+            if (!batch.empty()) {
+                {
+                    ProfiledLock lock(flightsMutex);
+                    
+                    for (auto& newFlight : batch) {
+                        Flight* flightPtr = newFlight.get();
+                        spawned.push_back(flightPtr);
+                        events.publish(flightEvent(SimEventType::FlightAdded, *flightPtr));
+                        flights.push_back(std::move(newFlight));
+                        publishStatus(*flightPtr);
                     }
-                    return;  // End the flight thread
-                break;
-                default:
-                    break;
+                    nextFlightTimes = due;
+                }
+                
+                for (Flight* flight : spawned) {
+                    spawnLifecycle(*flight);
+                }
+                bool full = batch.size() == kMaxSpawnBatch;
+                batch.clear();
+                spawned.clear();
+                if (full) continue;  // Still behind; spawn the rest before sleeping
+            } else if (advanced) {
+                ProfiledLock lock(flightsMutex);
+                nextFlightTimes = due;
+            }
+            
+            // Sleep until the next arrival, waking at least every 100 ms to notice shutdown
+            auto wake = now + toWallTime(milliseconds(100));
+            for (const auto& nextTime : due) {
+                wake = std::min(wake, nextTime);
+            }
+            std::this_thread::sleep_until(wake);
+        }
+    }
+
+    // Runway management thread function
+    void runwayManagementThread() {
+        using namespace std::chrono;
+        g_tracer.nameThread("runway-dispatcher");
+        AllocTracker::tagThread(AllocSubsystem::Dispatch);
+        pinCurrentThread(g_lowLatency.dispatcherCore, "runway dispatcher");
+        if (g_lowLatency.realtimePriority > 0) {
+            useRealtimeScheduling(g_lowLatency.realtimePriority, "runway dispatcher");
+        }
+        // Reserved up front so the dispatcher rarely reallocates mid-run
+        const bool recordLatency = g_lowLatency.enabled();
+        if (recordLatency) {
+            constexpr size_t kReservedSamples = 1 << 16;
+            dispatchLatencyNs.reserve(kReservedSamples);
+            tickLatenessNs.reserve(kReservedSamples);
+        }
+        auto lastAnalyticsTime = steady_clock::now();
+        auto tickPeriod = toWallTime(milliseconds(500));
+        auto nextTick = lastAnalyticsTime + tickPeriod;
+        
+        while (simulationRunning) {
+            auto now = steady_clock::now();
+            
+            // Display analytics every 30 seconds
+            if (!headless && toSimTime(now - lastAnalyticsTime) >= seconds(30)) {
+                displayAnalytics();
+                lastAnalyticsTime = now;
+            }
+            
+            // Wait for the next tick. A busy-polling dispatcher also runs as
+            // soon as a flight queues or a runway frees up.
+            if (g_lowLatency.busyPoll) {
+                while (simulationRunning && dispatchRequestNs.load(std::memory_order_relaxed) == 0 &&
+                       steady_clock::now() < nextTick) {
+                    cpuRelax();
+                }
+            } else {
+                std::this_thread::sleep_until(nextTick);
+            }
+            
+            now = steady_clock::now();
+            if (now >= nextTick) {
+                if (recordLatency) {
+                    tickLatenessNs.push_back(duration_cast<nanoseconds>(now - nextTick).count());
+                }
+                nextTick = std::max(nextTick + tickPeriod, now);
+            }
+            
+            // Process runway queues; the latency sample is stored after the lock is released
+            int64_t latencyNs = -1;
+            {
+                TraceScope trace("runway dispatch", "runway");
+                ProfiledLock lock(flightsMutex);
+                int64_t requested = dispatchRequestNs.exchange(0);
+                if (requested != 0 && recordLatency) {
+                    latencyNs = monotonicNs() - requested;
+                }
+                dispatchRunways();
+            }
+            if (latencyNs >= 0) {
+                dispatchLatencyNs.push_back(latencyNs);
+            }
+        }
+
+        // Wake flights still waiting for a runway so their lifecycles can end
+        ProfiledLock lock(flightsMutex);
+        for (int c = 0; c < kRunwayClassCount; c++) {
+            RunwayClass runwayClass = static_cast<RunwayClass>(c);
+            while (!runwayQueues.empty(runwayClass)) {
+                Flight* flight = runwayQueues.top(runwayClass);
+                runwayQueues.pop(runwayClass);
+                flight->inRunwayQueue = false;
+                resumeRunwayWaiter(*flight);
+            }
+        }
+    }
+
+    static double percentileUs(const std::vector<int64_t>& sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+        return sorted[index] / 1e3;
+    }
+
+    // Runway grant latency per EmergencyType against its SLO
+    void printEmergencySlo() {
+        ProfiledLock lock(flightsMutex);
+        size_t total = 0;
+        for (const auto& samples : emergencyGrantMs) total += samples.size();
+        if (total == 0) return;
+
+        ProfiledLock consoleLock(g_console_mutex);
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        std::cout << "\n=== EMERGENCY RUNWAY SLO ===\n";
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << std::left << std::setw(20) << "Emergency" << std::right << std::setw(8) << "SLO(s)"
+                  << std::setw(8) << "Grants" << std::setw(8) << "Missed" << std::setw(9) << "p50(s)"
+                  << std::setw(9) << "p95(s)" << std::setw(9) << "max(s)" << "\n";
+        for (int type = 1; type < kEmergencyTypeCount; type++) {
+            EmergencyPolicy policy = emergencyPolicy(static_cast<EmergencyType>(type));
+            std::vector<int64_t> samples = emergencyGrantMs[type];
+            std::sort(samples.begin(), samples.end());
+            auto seconds = [&](double p) {
+                if (samples.empty()) return 0.0;
+                return samples[std::min(samples.size() - 1, static_cast<size_t>(p * (samples.size() - 1) + 0.5))] / 1000.0;
+            };
+            std::cout << std::left << std::setw(20) << policy.name << std::right
+                      << std::setw(8) << policy.grantSloMs / 1000.0 << std::setw(8) << samples.size()
+                      << std::setw(8) << emergencySloMisses[type]
+                      << std::setw(9) << seconds(0.50)
+                      << std::setw(9) << seconds(0.95)
+                      << std::setw(9) << seconds(1.0) << "\n";
+        }
+        std::cout << "============================\n";
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    // Call after the dispatcher thread has been joined
+    void printDispatchLatency() {
+        ProfiledLock consoleLock(g_console_mutex);
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        std::cout << "\n=== DISPATCH LATENCY ===\n";
+        std::cout << "Dispatcher: " << (g_lowLatency.busyPoll ? "busy-poll" : "sleeping");
+        if (g_lowLatency.dispatcherCore >= 0) std::cout << ", core " << g_lowLatency.dispatcherCore;
+        if (g_lowLatency.realtimePriority > 0) std::cout << ", SCHED_FIFO " << g_lowLatency.realtimePriority;
+        if (g_lowLatency.workerCore >= 0) std::cout << " | Workers: core " << g_lowLatency.workerCore;
+        std::cout << "\n" << std::fixed << std::setprecision(1);
+        std::cout << std::left << std::setw(22) << "Latency (us)" << std::right << std::setw(10) << "samples"
+                  << std::setw(11) << "p50" << std::setw(11) << "p99" << std::setw(11) << "p99.9"
+                  << std::setw(11) << "max" << "\n";
+        std::pair<const char*, std::vector<int64_t>*> rows[] = {
+            {"Request -> dispatch", &dispatchLatencyNs}, {"Tick lateness", &tickLatenessNs}};
+        for (auto& row : rows) {
+            std::vector<int64_t>& samples = *row.second;
+            std::sort(samples.begin(), samples.end());
+            std::cout << std::left << std::setw(22) << row.first << std::right << std::setw(10) << samples.size()
+                      << std::setw(11) << percentileUs(samples, 0.50)
+                      << std::setw(11) << percentileUs(samples, 0.99)
+                      << std::setw(11) << percentileUs(samples, 0.999)
+                      << std::setw(11) << percentileUs(samples, 1.0) << "\n";
+        }
+        std::cout << "============================\n";
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    std::string flightPhaseToString(FlightPhase phase) {
+        switch (phase) {
+            case FlightPhase::Holding: return "Holding";
+            case FlightPhase::Approach: return "Approach";
+            case FlightPhase::Landing: return "Landing";
+            case FlightPhase::Taxi: return "Taxi";
+            case FlightPhase::AtGate: return "At Gate";
+            case FlightPhase::TakeoffRoll: return "Takeoff Roll";
+            case FlightPhase::Climb: return "Climb";
+            case FlightPhase::Cruise: return "Cruise";
+            case FlightPhase::Departure: return "Departure";
+            default: return "Unknown";
+        }
+    }
+
+    // Analytics functions
+    void displayAnalytics() {
+        TraceScope trace("displayAnalytics", "analytics");
+        ProfiledLock lock(flightsMutex);
+        ProfiledLock avnLock(avnMutex);
+        ProfiledLock consoleLock(g_console_mutex);
+        
+        // Get current time
+        auto now = std::chrono::system_clock::now();
+        auto time = std::chrono::system_clock::to_time_t(now);
+        
+        std::cout << "\n=== ATC DASHBOARD ===\n";
+        std::cout << "Time: " << std::put_time(std::localtime(&time), "%H:%M:%S") << "\n";
+
+        // Count active flights and their states
+        int activeFlights = 0;
+        int activeViolations = 0;
+        int flightsInAir = 0;
+        int flightsOnGround = 0;
+        int emergencyFlights = 0;
+        std::map<std::string, int> airlineCounts;
+        std::map<FlightPhase, int> phaseCounts;
+        
+        for (const auto& flight : flights) {
+            activeFlights++;
+            if (flight->violationActive) activeViolations++;
+            if (flight->emergencyType != EmergencyType::None) emergencyFlights++;
+            
+            if (flight->phase == FlightPhase::Holding || 
+                flight->phase == FlightPhase::Approach || 
+                flight->phase == FlightPhase::Landing ||
+                flight->phase == FlightPhase::Climb || 
+                flight->phase == FlightPhase::Cruise) {
+                flightsInAir++;
+            } else {
+                flightsOnGround++;
+            }
+            
+            airlineCounts[flight->airline->name]++;
+            phaseCounts[flight->phase]++;
+        }
+        
+        // Display counts
+        std::cout << "Active Flights: " << activeFlights << "\n";
+        std::cout << "In Air: " << flightsInAir << " | On Ground: " << flightsOnGround << "\n";
+        std::cout << "Emergency Flights: " << emergencyFlights << "\n";
+        std::cout << "Active Violations: " << activeViolations << "\n";
+        
+        // Display runway status
+        std::cout << "RUNWAY STATUS:\n";
+        for (const auto& runway : runways) {
+            std::cout << "  " << std::left << std::setw(30) << runway->name 
+                      << (runway->occupied.load() ? "OCCUPIED" : "AVAILABLE") << "\n";
+        }
+        
+        double elapsedHours = simulationTimeMs() / 3600000.0;
+        std::cout << "RUNWAY MOVEMENTS: " << runwayMovements.load() << " | "
+                  << static_cast<int64_t>(elapsedHours > 0.0 ? runwayMovements.load() / elapsedHours : 0.0)
+                  << "/hour | Buffers: " << separationBufferMs[0] / 1000.0 << "s arr, "
+                  << separationBufferMs[1] / 1000.0 << "s dep, " << separationBufferMs[2] / 1000.0 << "s cargo/emergency\n";
+        auto eventCount = [this](SimEventType type) { return eventCounts[static_cast<int>(type)].load(); };
+        std::cout << "EVENTS: " << eventCount(SimEventType::PhaseChanged) << " phase | "
+                  << eventCount(SimEventType::RunwayGranted) << " grants | "
+                  << eventCount(SimEventType::RunwayReleased) << " releases | "
+                  << eventCount(SimEventType::GroundFault) << " faults | "
+                  << eventCount(SimEventType::SpeedViolation) + eventCount(SimEventType::SeparationConflict)
+                  << " violations | " << eventCount(SimEventType::AVNIssued) << " AVNs\n";
+        
+        // Display runway queues with the ETA of the last flight in each
+        const char* classNames[kRunwayClassCount] = {"Arrival", "Departure", "Cargo/Emergency"};
+        std::cout << "RUNWAY QUEUES:";
+        for (int c = 0; c < kRunwayClassCount; c++) {
+            RunwayClass runwayClass = static_cast<RunwayClass>(c);
+            size_t depth = runwayQueues.size(runwayClass);
+            int servers;
+            int64_t freeAt = std::max(simulationTimeMs(), classFreeAtMs(runwayClass, servers));
+            int64_t tailWaitMs = depth == 0 ? 0 : freeAt - simulationTimeMs() +
+                                 static_cast<int64_t>(depth - 1) * etaModel->meanHoldMs(runwayClass) / servers;
+            std::cout << (c ? " |" : "") << " " << classNames[c] << " " << depth
+                      << " (last ETA " << tailWaitMs / 1000 << "s)";
+        }
+        std::cout << "\n";
+        
+        // Display emergency runway grants against their SLO
+        std::cout << "EMERGENCY GRANTS:";
+        for (int type = 1; type < kEmergencyTypeCount; type++) {
+            EmergencyPolicy policy = emergencyPolicy(static_cast<EmergencyType>(type));
+            size_t grants = emergencyGrantMs[type].size();
+            std::cout << (type > 1 ? " |" : "") << " " << policy.name << " "
+                      << grants - emergencySloMisses[type] << "/" << grants
+                      << " within " << policy.grantSloMs / 1000 << "s";
+        }
+        std::cout << "\n";
+        
+        // Display gate status
+        GateAllocator::Stats gateStats = gateAllocator->stats(simulationTimeMs());
+        std::cout << "GATES: " << gateStats.occupied << "/" << gateStats.gates << " occupied"
+                  << " | Utilization: " << static_cast<int>(gateStats.utilization * 100) << "%"
+                  << " | Waiting: " << gateStats.waiting << "\n";
+        std::cout << "  Gate waits: " << gateStats.waits << " of " << gateStats.assignments
+                  << " assignments, mean " << static_cast<int64_t>(gateStats.meanWaitMs) / 1000
+                  << "s, max " << gateStats.maxWaitMs / 1000 << "s\n";
+
+        // Display airspace separation status
+        std::cout << "AIRSPACE: " << airborneCount.load() << " airborne"
+                  << " | Active conflicts: " << activeConflicts.load()
+                  << " | Total conflicts: " << totalConflicts.load() << "\n";
+        
+        // Display airline activity
+        std::cout << "AIRLINE ACTIVITY:\n";
+        for (const auto& entry : airlineCounts) {
+            std::cout << "  " << std::left << std::setw(20) << entry.first 
+                      << ": " << entry.second << " flights\n";
+        }
+        
+        // Display phase distribution
+        std::cout << "FLIGHT PHASES:\n";
+        for (const auto& entry : phaseCounts) {
+            std::cout << "  " << std::left << std::setw(20) << flightPhaseToString(entry.first) 
+                      << ": " << entry.second << "\n";
+        }
+        
+        std::cout << "============================\n\n";
+    }
+
+    // Also write the end-of-run report as JSON; call before startSimulation
+    void setRunReportPath(const std::string& path) { runReportPath = path; }
+
+    // Copy every flight into report records. Flights stay in the table after
+    // they retire, so this covers the whole run, restored history included.
+    RunReportInput runReportInput() {
+        RunReportInput input;
+        for (const auto& airline : airlines) input.airlines.push_back(airline.name);
+        for (const auto& runway : runways) input.runways.push_back(runway->name);
+        input.durationMs = simulationTimeMs();
+
+        ProfiledLock lock(flightsMutex);
+        ProfiledLock avnLock(avnMutex);
+        avnGenerator->syncAnalytics(avnAnalytics);
+        std::vector<AVNAnalytics::FineTotals> fines = avnAnalytics.finesByAirline();
+        input.fines.resize(input.airlines.size());
+        for (size_t i = 0; i < fines.size(); i++) {
+            auto it = std::find(input.airlines.begin(), input.airlines.end(), avnAnalytics.airlines()[i]);
+            if (it != input.airlines.end()) input.fines[it - input.airlines.begin()] = fines[i];
+        }
+
+        input.flights.reserve(flights.size());
+        for (const auto& flight : flights) {
+            ReportFlight record;
+            record.flightNumber = flight->flightNumber;
+            ptrdiff_t airline = flight->airline - airlines.data();
+            record.airline = airline >= 0 && airline < static_cast<ptrdiff_t>(airlines.size())
+                                 ? static_cast<uint16_t>(airline) : UINT16_MAX;
+            record.direction = static_cast<uint8_t>(flight->direction);
+            record.state = flight->hasFault ? 2 : flight->lifecycleComplete ? 1 : 0;
+            record.delayMs = static_cast<int32_t>(std::min<int64_t>(flight->delayMs, INT32_MAX));
+            record.runway = static_cast<int16_t>(flight->runwayUsed);
+            record.violations = static_cast<uint16_t>(std::min<size_t>(flight->avnIDs.size(), UINT16_MAX));
+            record.runwayEnterMs = flight->runwayEnterMs;
+            record.runwayExitMs = flight->runwayExitMs;
+            input.flights.push_back(record);
+        }
+        return input;
+    }
+
+    // Final report over the run: console summary, and JSON with --report
+    void writeRunReport() {
+        TraceScope trace("writeRunReport", "analytics");
+        RunReport report = RunReport::build(runReportInput(), std::max(1u, std::thread::hardware_concurrency()));
+        ProfiledLock consoleLock(g_console_mutex);
+        if (!headless) {
+            report.print(std::cout);
+        }
+        if (!runReportPath.empty() && report.writeJson(runReportPath)) {
+            std::cout << "Run report written to " << runReportPath << "\n";
+        }
+    }
+
+    // Time the run report over `count` synthetic flights, sized so the
+    // runways are about 70% busy, on one thread and on every core
+    void runReportBenchmark(uint64_t count) {
+        RunReportInput input;
+        for (const auto& airline : airlines) input.airlines.push_back(airline.name);
+        for (const auto& runway : runways) input.runways.push_back(runway->name);
+        input.fines.resize(input.airlines.size());
+        input.durationMs = std::max<int64_t>(3600000, count * 67500 / runways.size() * 10 / 7);
+
+        std::mt19937_64 rng(42);
+        std::exponential_distribution<double> delay(1.0 / 90000.0);
+        std::uniform_int_distribution<int64_t> enter(0, input.durationMs - 90000);
+        input.flights.resize(count);
+        for (uint64_t i = 0; i < count; i++) {
+            ReportFlight& flight = input.flights[i];
+            flight.flightNumber = static_cast<int32_t>(i);
+            flight.airline = static_cast<uint16_t>(rng() % input.airlines.size());
+            flight.direction = static_cast<uint8_t>(rng() % kReportDirections);
+            flight.state = rng() % 100 < 2 ? 2 : 1;
+            flight.delayMs = static_cast<int32_t>(std::min(delay(rng), 3600000.0));
+            flight.runway = static_cast<int16_t>(rng() % input.runways.size());
+            flight.violations = rng() % 20 == 0 ? 1 : 0;
+            flight.runwayEnterMs = enter(rng);
+            flight.runwayExitMs = flight.runwayEnterMs + 45000 + static_cast<int64_t>(rng() % 45000);
+            AVNAnalytics::FineTotals& fines = input.fines[flight.airline];
+            if (flight.violations) {
+                double fine = AVNGenerator::fineAmountFor(airlines[flight.airline].type);
+                fines.issued++;
+                fines.finesIssued += fine;
+                if (rng() % 2) {
+                    fines.paid++;
+                    fines.finesPaid += fine;
+                }
+            }
+        }
+
+        int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        RunReport serial = RunReport::build(input, 1);
+        RunReport parallel = RunReport::build(input, cores);
+
+        ProfiledLock consoleLock(g_console_mutex);
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        parallel.print(std::cout);
+        std::cout << "\n=== RUN REPORT BENCHMARK ===\n";
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Flights: " << count << " | Runways: " << runways.size() << " | Airlines: " << airlines.size() << "\n";
+        std::cout << "1 thread: " << serial.buildMs << " ms | " << parallel.threads << " threads: "
+                  << parallel.buildMs << " ms (" << (parallel.buildMs > 0 ? count / parallel.buildMs / 1000.0 : 0.0)
+                  << "M flights/s)\n";
+        std::cout << "============================\n";
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+        if (!runReportPath.empty() && parallel.writeJson(runReportPath)) {
+            std::cout << "Run report written to " << runReportPath << "\n";
+        }
+    }
+
+    // Write the complete simulation state to a memory-mappable checkpoint.
+    // State is copied under the locks first; the file is written afterwards
+    // so the simulation threads are only held for the copy.
+    bool saveCheckpoint(const std::string& path) {
+        using namespace std::chrono;
+        events.flush();  // Issued AVNs reach shared memory before it is copied
+        std::vector<CheckpointFlight> flightRecords;
+        std::vector<int32_t> queueRecords;
+        std::vector<int32_t> avnIdRecords;
+        std::vector<int64_t> scheduleRecords;
+        std::vector<int32_t> runwayRecords(runways.size(), -1);
+        std::string stringPool;
+        int64_t elapsedMs = 0;
+        uint32_t nextFlightNumber = 0;
+
+        {
+            ProfiledLock lock(flightsMutex);
+            ProfiledLock avnLock(avnMutex);
+            auto steadyNow = steady_clock::now();
+            std::map<const Flight*, int32_t> flightIndex;
+
+            flightRecords.reserve(flights.size());
+            for (const auto& flight : flights) {
+                // Only these phases hold a runway. A grant the lifecycle has
+                // not acted on yet is dropped; the restored flight asks again.
+                FlightPhase phase = flight->phase.load();
+                bool holdsRunway = flight->runwayAssigned != -1 &&
+                                   (phase == FlightPhase::Approach || phase == FlightPhase::Landing ||
+                                    phase == FlightPhase::TakeoffRoll);
+                CheckpointFlight record{};
+                record.flightNumber = flight->flightNumber;
+                record.airlineIndex = static_cast<int32_t>(flight->airline - airlines.data());
+                record.aircraftType = static_cast<uint8_t>(flight->aircraftType);
+                record.direction = static_cast<uint8_t>(flight->direction);
+                record.phase = static_cast<uint8_t>(phase);
+                record.emergencyType = static_cast<uint8_t>(flight->emergencyType);
+                record.priorityLevel = static_cast<uint8_t>(flight->priorityLevel);
+                if (flight->violationActive) record.flags |= kCheckpointViolationActive;
+                if (flight->hasFault) record.flags |= kCheckpointHasFault;
+                if (flight->lifecycleComplete) record.flags |= kCheckpointLifecycleComplete;
+                if (holdsRunway && flight->runwayOccupied) record.flags |= kCheckpointRunwayOccupied;
+                if (flight->inRunwayQueue) record.flags |= kCheckpointInRunwayQueue;
+                record.speed = flight->speed;
+                record.runwayAssigned = holdsRunway ? flight->runwayAssigned : -1;
+                record.gateAssigned = static_cast<int16_t>(flight->gateAssigned);
+                record.estimatedWaitTime = static_cast<int32_t>(
+                    std::min<int64_t>(expectedRunwayWaitMs(*flight), INT32_MAX));
+                record.scheduledTimeMs = duration_cast<milliseconds>(flight->scheduledTime.time_since_epoch()).count();
+                record.actualTimeMs = duration_cast<milliseconds>(flight->actualTime.time_since_epoch()).count();
+                record.phaseElapsedMs = duration_cast<milliseconds>(toSimTime(steadyNow - flight->phaseStart)).count();
+                record.delayMs = flight->delayMs;
+                record.runwayUsed = flight->runwayUsed;
+                record.runwayEnterMs = flight->runwayEnterMs;
+                record.runwayExitMs = flight->runwayExitMs;
+                record.avnIdOffset = static_cast<uint32_t>(avnIdRecords.size());
+                record.avnIdCount = static_cast<uint32_t>(flight->avnIDs.size());
+                avnIdRecords.insert(avnIdRecords.end(), flight->avnIDs.begin(), flight->avnIDs.end());
+                record.violationOffset = static_cast<uint32_t>(stringPool.size());
+                record.violationLength = static_cast<uint32_t>(flight->violationReason.size());
+                stringPool += flight->violationReason;
+                record.faultOffset = static_cast<uint32_t>(stringPool.size());
+                record.faultLength = static_cast<uint32_t>(flight->faultDescription.size());
+                stringPool += flight->faultDescription;
+
+                if ((record.flags & kCheckpointRunwayOccupied) &&
+                    flight->runwayAssigned < static_cast<int>(runways.size())) {
+                    runwayRecords[flight->runwayAssigned] = flight->flightNumber;
+                }
+                flightIndex[flight.get()] = static_cast<int32_t>(flightRecords.size());
+                flightRecords.push_back(record);
+            }
+
+            for (Flight* queued : runwayQueues.ordered()) {
+                queueRecords.push_back(flightIndex[queued]);
+            }
+
+            for (const auto& nextTime : nextFlightTimes) {
+                scheduleRecords.push_back(duration_cast<milliseconds>(toSimTime(nextTime - steadyNow)).count());
             }
 
-            // Check for ground faults if still active
             if (simulationRunning) {
-                checkGroundFaults(flight);
+                elapsedMs = duration_cast<milliseconds>(toSimTime(steadyNow - simulationStartTime)).count();
+            } else {
+                elapsedMs = restoredElapsed.count();
+            }
+            nextFlightNumber = flightNumberCounter.load();
+        }
+
+        int avnCounter = 0;
+        std::vector<SharedAVN> avnRecords = avnGenerator->snapshotAVNs(avnCounter);
+
+        // Lay out the sections back to back after the header
+        CheckpointHeader header{};
+        std::memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+        header.version = kCheckpointVersion;
+        header.flightCount = static_cast<uint32_t>(flightRecords.size());
+        header.queueCount = static_cast<uint32_t>(queueRecords.size());
+        header.avnIdCount = static_cast<uint32_t>(avnIdRecords.size());
+        header.avnCount = static_cast<uint32_t>(avnRecords.size());
+        header.scheduleCount = static_cast<uint32_t>(scheduleRecords.size());
+        header.runwayCount = static_cast<uint32_t>(runwayRecords.size());
+        header.stringPoolSize = static_cast<uint32_t>(stringPool.size());
+        header.simulationElapsedMs = elapsedMs;
+        header.nextFlightNumber = nextFlightNumber;
+        header.avnCounter = avnCounter;
+
+        uint64_t offset = sizeof(CheckpointHeader);
+        auto placeSection = [&offset](uint64_t bytes) {
+            offset = (offset + 7) & ~uint64_t(7);
+            uint64_t start = offset;
+            offset += bytes;
+            return start;
+        };
+        header.flightsOffset = placeSection(flightRecords.size() * sizeof(CheckpointFlight));
+        header.queueOffset = placeSection(queueRecords.size() * sizeof(int32_t));
+        header.avnIdsOffset = placeSection(avnIdRecords.size() * sizeof(int32_t));
+        header.avnsOffset = placeSection(avnRecords.size() * sizeof(SharedAVN));
+        header.schedulesOffset = placeSection(scheduleRecords.size() * sizeof(int64_t));
+        header.runwaysOffset = placeSection(runwayRecords.size() * sizeof(int32_t));
+        header.stringPoolOffset = placeSection(stringPool.size());
+
+        std::vector<char> buffer(offset, 0);
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        auto copySection = [&buffer](uint64_t at, const void* data, size_t bytes) {
+            if (bytes > 0) std::memcpy(buffer.data() + at, data, bytes);
+        };
+        copySection(header.flightsOffset, flightRecords.data(), flightRecords.size() * sizeof(CheckpointFlight));
+        copySection(header.queueOffset, queueRecords.data(), queueRecords.size() * sizeof(int32_t));
+        copySection(header.avnIdsOffset, avnIdRecords.data(), avnIdRecords.size() * sizeof(int32_t));
+        copySection(header.avnsOffset, avnRecords.data(), avnRecords.size() * sizeof(SharedAVN));
+        copySection(header.schedulesOffset, scheduleRecords.data(), scheduleRecords.size() * sizeof(int64_t));
+        copySection(header.runwaysOffset, runwayRecords.data(), runwayRecords.size() * sizeof(int32_t));
+        copySection(header.stringPoolOffset, stringPool.data(), stringPool.size());
+
+        // Write to a temporary file and rename so a crash never leaves a torn checkpoint
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!out) {
+                ProfiledLock consoleLock(g_console_mutex);
+                std::cerr << "Failed to write checkpoint " << tempPath << std::endl;
+                return false;
             }
         }
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+            ProfiledLock consoleLock(g_console_mutex);
+            std::cerr << "Failed to move checkpoint into place at " << path << std::endl;
+            return false;
+        }
+
+        ProfiledLock consoleLock(g_console_mutex);
+        std::cout << "\n=== CHECKPOINT SAVED ===\n";
+        std::cout << "File: " << path << " (" << buffer.size() << " bytes)\n";
+        std::cout << "Flights: " << header.flightCount << " | Queued: " << header.queueCount
+                  << " | AVNs: " << header.avnCount << "\n";
+        std::cout << "============================\n";
+        return true;
     }
 
-    void checkSpeedViolation(Flight& flight) {
-        float permissibleSpeed = 0.0f;
-        bool violation = false;
-        std::string violationReason;
+    // Load a checkpoint written by saveCheckpoint. Must be called before
+    // startSimulation; lifecycles resume from their saved phase on start.
+    bool restoreCheckpoint(const std::string& path) {
+        using namespace std::chrono;
+        if (simulationRunning) {
+            std::cerr << "Cannot restore a checkpoint while the simulation is running" << std::endl;
+            return false;
+        }
 
-        switch (flight.phase) {
-            case FlightPhase::Holding:
-                permissibleSpeed = 600.0f;
-                if (flight.speed > 600.0f || flight.speed < 400.0f) {
-                    violation = true;
-                    violationReason = "Speed outside holding range (400-600 km/h)";
-                }
-                break;
-            case FlightPhase::Approach:
-                permissibleSpeed = 290.0f;
-                if (flight.speed < 240.0f || flight.speed > 290.0f) {
-                    violation = true;
-                    violationReason = "Speed outside approach range (240-290 km/h)";
-                }
-                break;
-            case FlightPhase::Landing:
-                permissibleSpeed = 240.0f;
-                if (flight.speed > 240.0f) {
-                    violation = true;
-                    violationReason = "Exceeded landing speed limit (240 km/h)";
-                }
-                break;
-            case FlightPhase::Taxi:
-                permissibleSpeed = 30.0f;
-                if (flight.speed > 30.0f || flight.speed < 15.0f) {
-                    violation = true;
-                    violationReason = "Speed outside taxi range (15-30 km/h)";
-                }
-                break;
-            case FlightPhase::AtGate:
-                permissibleSpeed = 5.0f;
-                if (flight.speed > 5.0f) {
-                    violation = true;
-                    violationReason = "Exceeded gate speed limit (5 km/h)";
+        try {
+            bip::file_mapping file(path.c_str(), bip::read_only);
+            bip::mapped_region region(file, bip::read_only);
+            const char* base = static_cast<const char*>(region.get_address());
+            size_t size = region.get_size();
+
+            if (size < sizeof(CheckpointHeader)) {
+                std::cerr << "Checkpoint " << path << " is truncated" << std::endl;
+                return false;
+            }
+            const auto* header = reinterpret_cast<const CheckpointHeader*>(base);
+            if (std::memcmp(header->magic, kCheckpointMagic, sizeof(header->magic)) != 0 ||
+                header->version != kCheckpointVersion) {
+                std::cerr << "Checkpoint " << path << " has an unknown format" << std::endl;
+                return false;
+            }
+
+            auto sectionFits = [size](uint64_t at, uint64_t bytes) {
+                return at <= size && bytes <= size - at;
+            };
+            if (!sectionFits(header->flightsOffset, uint64_t(header->flightCount) * sizeof(CheckpointFlight)) ||
+                !sectionFits(header->queueOffset, uint64_t(header->queueCount) * sizeof(int32_t)) ||
+                !sectionFits(header->avnIdsOffset, uint64_t(header->avnIdCount) * sizeof(int32_t)) ||
+                !sectionFits(header->avnsOffset, uint64_t(header->avnCount) * sizeof(SharedAVN)) ||
+                !sectionFits(header->schedulesOffset, uint64_t(header->scheduleCount) * sizeof(int64_t)) ||
+                !sectionFits(header->runwaysOffset, uint64_t(header->runwayCount) * sizeof(int32_t)) ||
+                !sectionFits(header->stringPoolOffset, header->stringPoolSize) ||
+                header->scheduleCount != flightSchedules.size() ||
+                header->runwayCount != runways.size()) {
+                std::cerr << "Checkpoint " << path << " does not match this airport layout" << std::endl;
+                return false;
+            }
+
+            const auto* flightRecords = reinterpret_cast<const CheckpointFlight*>(base + header->flightsOffset);
+            const auto* queueRecords = reinterpret_cast<const int32_t*>(base + header->queueOffset);
+            const auto* avnIdRecords = reinterpret_cast<const int32_t*>(base + header->avnIdsOffset);
+            const auto* avnRecords = reinterpret_cast<const SharedAVN*>(base + header->avnsOffset);
+            const auto* scheduleRecords = reinterpret_cast<const int64_t*>(base + header->schedulesOffset);
+            const char* stringPool = base + header->stringPoolOffset;
+
+            // Check every record before touching any state, so a bad file
+            // leaves the controller as it was
+            const int32_t runwayCount = static_cast<int32_t>(runways.size());
+            const int32_t gateCount = gateAllocator->gateCount();
+            for (uint32_t i = 0; i < header->flightCount; i++) {
+                const CheckpointFlight& record = flightRecords[i];
+                if (record.phase >= kFlightPhaseCount ||
+                    record.direction > static_cast<uint8_t>(FlightDirection::WestDeparture) ||
+                    record.aircraftType > static_cast<uint8_t>(AircraftType::Emergency) ||
+                    record.emergencyType >= kEmergencyTypeCount ||
+                    record.airlineIndex < 0 || record.airlineIndex >= static_cast<int32_t>(airlines.size()) ||
+                    record.runwayAssigned < -1 || record.runwayAssigned >= runwayCount ||
+                    record.runwayUsed < -1 || record.runwayUsed >= runwayCount ||
+                    record.gateAssigned < -1 || record.gateAssigned >= gateCount ||
+                    uint64_t(record.avnIdOffset) + record.avnIdCount > header->avnIdCount ||
+                    uint64_t(record.violationOffset) + record.violationLength > header->stringPoolSize ||
+                    uint64_t(record.faultOffset) + record.faultLength > header->stringPoolSize) {
+                    std::cerr << "Checkpoint " << path << " has a corrupt flight record (#" << i << ")" << std::endl;
+                    return false;
                 }
-                break;
-            case FlightPhase::TakeoffRoll:
-                permissibleSpeed = 290.0f;
-                if (flight.speed > 290.0f) {
-                    violation = true;
-                    violationReason = "Exceeded takeoff roll speed limit (290 km/h)";
+
+                // Runways are held from approach to the end of the landing roll
+                // and for the takeoff roll; saveCheckpoint writes nothing else
+                FlightPhase phase = static_cast<FlightPhase>(record.phase);
+                bool runwayPhase = phase == FlightPhase::Approach || phase == FlightPhase::Landing ||
+                                   phase == FlightPhase::TakeoffRoll;
+                if ((record.runwayAssigned != -1 && !runwayPhase) ||
+                    ((record.flags & kCheckpointRunwayOccupied) && record.runwayAssigned == -1)) {
+                    std::cerr << "Checkpoint " << path << " has an inconsistent runway record (#" << i << ")"
+                              << std::endl;
+                    return false;
                 }
-                break;
-            case FlightPhase::Climb:
-                permissibleSpeed = 463.0f;
-                if (flight.speed < 250.0f || flight.speed > 463.0f) {
-                    violation = true;
-                    violationReason = "Speed outside climb range (250-463 km/h)";
+            }
+
+            ProfiledLock lock(flightsMutex);
+            auto steadyNow = steady_clock::now();
+
+            flights.clear();
+            flights.reserve(header->flightCount);
+            for (uint32_t i = 0; i < header->flightCount; i++) {
+                const CheckpointFlight& record = flightRecords[i];
+                auto flight = std::make_unique<Flight>(
+                    record.flightNumber, &airlines[record.airlineIndex],
+                    static_cast<AircraftType>(record.aircraftType),
+                    static_cast<FlightDirection>(record.direction),
+                    system_clock::time_point(milliseconds(record.scheduledTimeMs)),
+                    static_cast<EmergencyType>(record.emergencyType));
+                flight->actualTime = system_clock::time_point(milliseconds(record.actualTimeMs));
+                flight->phase = static_cast<FlightPhase>(record.phase);
+                flight->phaseStart = steadyNow - toWallTime(milliseconds(record.phaseElapsedMs));
+                flight->speed = record.speed;
+                flight->priorityLevel = record.priorityLevel;
+                flight->violationActive = (record.flags & kCheckpointViolationActive) != 0;
+                flight->hasFault = (record.flags & kCheckpointHasFault) != 0;
+                flight->lifecycleComplete = (record.flags & kCheckpointLifecycleComplete) != 0;
+                flight->runwayOccupied = (record.flags & kCheckpointRunwayOccupied) != 0;
+                flight->runwayAssigned = record.runwayAssigned;
+                flight->delayMs = record.delayMs;
+                flight->runwayUsed = record.runwayUsed;
+                flight->runwayEnterMs = record.runwayEnterMs;
+                flight->runwayExitMs = record.runwayExitMs;
+                if (record.gateAssigned != -1) {
+                    gateAllocator->occupy(record.gateAssigned, *flight,
+                                          header->simulationElapsedMs - record.phaseElapsedMs);
                 }
-                break;
-            case FlightPhase::Cruise:
-                permissibleSpeed = 900.0f;
-                if (flight.speed < 800.0f || flight.speed > 900.0f) {
-                    violation = true;
-                    violationReason = "Speed outside cruise range (800-900 km/h)";
+                flight->avnIDs.assign(avnIdRecords + record.avnIdOffset,
+                                      avnIdRecords + record.avnIdOffset + record.avnIdCount);
+                flight->violationReason.assign(stringPool + record.violationOffset, record.violationLength);
+                flight->faultDescription.assign(stringPool + record.faultOffset, record.faultLength);
+                flights.push_back(std::move(flight));
+            }
+
+            // Runway ownership
+            for (uint32_t i = 0; i < header->runwayCount; i++) {
+                runways[i]->occupied.store(false);
+            }
+            runwayGrantsOutstanding.assign(runways.size(), 0);
+            RunwayMask occupiedMask = 0;
+            for (const auto& flight : flights) {
+                if (flight->runwayAssigned < 0 || flight->runwayAssigned >= static_cast<int>(runways.size())) continue;
+                runwayGrantsOutstanding[flight->runwayAssigned]++;
+                if (flight->runwayOccupied) {
+                    runways[flight->runwayAssigned]->occupied.store(true);
+                    occupiedMask |= RunwayMask{1} << flight->runwayAssigned;
                 }
-                break;
-        }
+            }
+            RunwayMask free = 0;
+            for (size_t id = 0; id < runways.size(); id++) {
+                if (runwayGrantsOutstanding[id] == 0) free |= RunwayMask{1} << id;
+            }
+            freeRunways = free;
+            sharedRunwayStatus->occupiedMask = occupiedMask;
 
-        if (violation && !flight.violationActive) {
-            flight.violationActive = true;
-            flight.violationReason = violationReason;
-            
-            {
-                std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                std::cout << "\n=== SPEED VIOLATION DETECTED ===\n";
-                std::cout << "Flight: #" << flight.flightNumber 
-                          << " (" << flight.airline->name << ")\n";
-                std::cout << "Phase: " << flight.getPhaseString() << "\n";
-                std::cout << "Speed: " << flight.speed << " km/h (Limit: " << permissibleSpeed << " km/h)\n";
-                std::cout << "Reason: " << violationReason << "\n";
-                std::cout << "============================\n";
+            // Rebuild the runway queues in their saved order
+            runwayQueues.clear();
+            for (uint32_t i = 0; i < header->queueCount; i++) {
+                int32_t index = queueRecords[i];
+                if (index >= 0 && index < static_cast<int32_t>(flights.size())) {
+                    flights[index]->inRunwayQueue = true;
+                    runwayQueues.push(flights[index].get());
+                }
             }
-            
-            // Generate AVN and store its ID
-            int avnID = avnGenerator->generateAVN(&flight, permissibleSpeed);
-            flight.avnIDs.push_back(avnID);
-            
-            {
-                std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                std::cout << "\n=== AVN GENERATED ===\n";
-                std::cout << "AVN ID: #" << avnID << "\n";
-                std::cout << "Flight: #" << flight.flightNumber << "\n";
-                std::cout << "Airline: " << flight.airline->name << "\n";
-                std::cout << "============================\n";
+            flightIndex.clear();
+            for (const auto& flight : flights) {
+                publishStatus(*flight);
             }
+
+            // Generator schedule positions
+            nextFlightTimes.clear();
+            for (uint32_t i = 0; i < header->scheduleCount; i++) {
+                nextFlightTimes.push_back(steadyNow + toWallTime(milliseconds(scheduleRecords[i])));
+            }
+            flightNumberCounter = header->nextFlightNumber;
+            restoredElapsed = milliseconds(header->simulationElapsedMs);
+
+            avnGenerator->restoreAVNs(avnRecords, header->avnCount, header->avnCounter);
+
+            ProfiledLock consoleLock(g_console_mutex);
+            std::cout << "\n=== CHECKPOINT RESTORED ===\n";
+            std::cout << "File: " << path << "\n";
+            std::cout << "Flights: " << header->flightCount << " | Queued: " << header->queueCount
+                      << " | AVNs: " << header->avnCount << "\n";
+            std::cout << "Simulated time: " << header->simulationElapsedMs / 1000 << " seconds\n";
+            std::cout << "============================\n";
+            return true;
+        } catch (const bip::interprocess_exception& e) {
+            std::cerr << "Failed to open checkpoint " << path << ": " << e.what() << std::endl;
+            return false;
         }
     }
 
-    // Ground fault handling
-    void checkGroundFaults(Flight& flight) {
-        if (flight.phase == FlightPhase::Taxi || flight.phase == FlightPhase::AtGate) {
-            // 5% chance of fault during ground operations
-            static std::random_device rd;
-            static std::mt19937 gen(rd());
-            static std::uniform_real_distribution<> dis(0.0, 1.0);
-            
-            if (dis(gen) < 0.05 && !flight.hasFault) {
-                flight.hasFault = true;
-                // Randomly select fault type
-                const std::vector<std::string> faultTypes = {
-                    "Brake failure",
-                    "Hydraulic leak",
-                    "APU malfunction",
-                    "Steering system fault"
-                };
-                flight.faultDescription = faultTypes[rand() % faultTypes.size()];
-                
-                std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                std::cout << "\n=== GROUND FAULT DETECTED ===\n";
-                std::cout << "Flight: #" << flight.flightNumber << "\n";
-                std::cout << "Fault: " << flight.faultDescription << "\n";
-                std::cout << "Action: Aircraft being towed to maintenance\n";
-                std::cout << "============================\n";
-                
-                // Remove from active queues
-                removeFaultedFlight(flight);
+    // Headless stress mode: raise the offered arrival rate step by step until
+    // runway queue wait or depth diverges, then report the last sustainable rate
+    std::vector<SaturationStep> runSaturationTest(const SaturationConfig& config) {
+        using namespace std::chrono;
+        std::vector<SaturationStep> steps;
+
+        headless = true;
+        timeScale = config.timeScale;
+        simulationDuration = seconds(static_cast<long long>(config.stepMinutes) * 60 * (config.maxSteps + 1));
+        offeredRatePerHour = config.startRatePerHour;
+
+        // Silence the simulator; a stream without a buffer drops output cheaply
+        std::streambuf* consoleBuffer = std::cout.rdbuf(nullptr);
+
+        simulationRunning = true;
+        std::thread simulationThread(&ATCSController::startSimulation, this);
+
+        auto queueDepth = [this]() {
+            ProfiledLock lock(flightsMutex);
+            return runwayQueues.size();
+        };
+
+        for (int step = 0; step < config.maxSteps; step++) {
+            double rate = config.startRatePerHour + step * config.rateStepPerHour;
+            offeredRatePerHour = rate;
+
+            SaturationStep result{};
+            result.offeredRatePerHour = rate;
+            result.queueDepthStart = queueDepth();
+            result.queueDepthMax = result.queueDepthStart;
+            uint64_t grantsBefore = runwayGrants.load();
+            uint64_t waitBefore = runwayWaitTotalMs.load();
+            uint64_t acquisitionsBefore = flightsMutex.native().acquisitionCount();
+            uint64_t contendedBefore = flightsMutex.native().contendedCount();
+            double cpuBefore = processCpuSeconds();
+            auto wallBefore = steady_clock::now();
+
+            // Sample the queue once per simulated minute
+            for (int minute = 0; minute < config.stepMinutes && simulationRunning; minute++) {
+                std::this_thread::sleep_for(toWallTime(minutes(1)));
+                result.queueDepthMax = std::max(result.queueDepthMax, queueDepth());
+            }
+
+            double wallSeconds = duration<double>(steady_clock::now() - wallBefore).count();
+            uint64_t grants = runwayGrants.load() - grantsBefore;
+            result.queueDepthEnd = queueDepth();
+            result.achievedRatePerHour = grants * 60.0 / config.stepMinutes;
+            result.meanWaitSeconds = grants > 0 ? (runwayWaitTotalMs.load() - waitBefore) / 1000.0 / grants : 0.0;
+            result.cpuUtilization = wallSeconds > 0 ? (processCpuSeconds() - cpuBefore) / wallSeconds : 0.0;
+            result.residentSetKB = residentSetKB();
+            result.lockAcquisitions = flightsMutex.native().acquisitionCount() - acquisitionsBefore;
+            result.lockContended = flightsMutex.native().contendedCount() - contendedBefore;
+            result.sustainable =
+                result.queueDepthEnd <= result.queueDepthStart + config.maxQueueGrowth &&
+                result.meanWaitSeconds <= config.maxMeanWaitSeconds;
+            steps.push_back(result);
+
+            if (!result.sustainable || !simulationRunning) {
+                break;
             }
         }
+
+        simulationRunning = false;
+        flightGenerationRunning = false;
+        if (simulationThread.joinable()) {
+            simulationThread.join();
+        }
+
+        std::cout.rdbuf(consoleBuffer);
+        return steps;
     }
 
-    void removeFaultedFlight(Flight& flight) {
-        std::lock_guard<std::mutex> lock(flightsMutex);
-        // Remove from runway queue if present
-        std::vector<Flight*> tempQueue;
-        while (!runwayQueue.empty()) {
-            Flight* f = runwayQueue.top();
-            runwayQueue.pop();
-            if (f->flightNumber != flight.flightNumber) {
-                tempQueue.push_back(f);
+    void printSaturationReport(const std::vector<SaturationStep>& steps) {
+        double maxSustainable = 0.0;
+        double maxAchieved = 0.0;
+        for (const auto& step : steps) {
+            if (step.sustainable) {
+                maxSustainable = step.offeredRatePerHour;
+                maxAchieved = std::max(maxAchieved, step.achievedRatePerHour);
             }
         }
-        for (auto* f : tempQueue) {
-            runwayQueue.push(f);
+
+        ProfiledLock consoleLock(g_console_mutex);
+        std::cout << "\n=== SATURATION REPORT ===\n";
+        std::cout << "Runways: " << runways.size() << "\n";
+        for (const auto& runway : runways) {
+            std::cout << "  " << runway->name << "\n";
         }
-        
-        // Release runway if assigned
-        if (flight.runwayAssigned != -1) {
-            releaseRunway(flight.runwayAssigned);
-            flight.runwayAssigned = -1;
+        std::cout << std::left << std::setw(9) << "Offered" << std::setw(10) << "Achieved"
+                  << std::setw(10) << "MeanWait" << std::setw(14) << "Queue s/e/max"
+                  << std::setw(7) << "CPU" << std::setw(10) << "RSS(KB)"
+                  << std::setw(12) << "Locks" << std::setw(11) << "Contended" << "Result\n";
+        for (const auto& step : steps) {
+            std::ostringstream queue;
+            queue << step.queueDepthStart << "/" << step.queueDepthEnd << "/" << step.queueDepthMax;
+            std::cout << std::left << std::fixed << std::setprecision(0)
+                      << std::setw(9) << step.offeredRatePerHour
+                      << std::setw(10) << step.achievedRatePerHour
+                      << std::setw(10) << step.meanWaitSeconds
+                      << std::setw(14) << queue.str()
+                      << std::setprecision(2) << std::setw(7) << step.cpuUtilization
+                      << std::setw(10) << step.residentSetKB
+                      << std::setw(12) << step.lockAcquisitions
+                      << std::setw(11) << step.lockContended
+                      << (step.sustainable ? "OK" : "DIVERGED") << "\n";
+        }
+        std::cout << std::setprecision(0);
+        if (maxSustainable > 0.0) {
+            std::cout << "Max sustainable rate: " << maxSustainable << " flights/hour offered, "
+                      << maxAchieved << " runway grants/hour\n";
+        } else {
+            std::cout << "No load step was sustainable; lower the start rate\n";
         }
+        std::cout << "============================\n";
     }
 
-    // Runway management functions
-    bool assignRunway(Flight& flight) {
-        // Determine preferred runway based on direction and type
-        int preferredRunway = -1;
-        
-        if (flight.aircraftType == AircraftType::Cargo || 
-            flight.aircraftType == AircraftType::Emergency) {
-            preferredRunway = 2; // RWY-C for cargo and emergency
-        } else if (flight.direction == FlightDirection::NorthArrival || 
-                   flight.direction == FlightDirection::SouthArrival) {
-            preferredRunway = 0; // RWY-A for arrivals
-        } else {
-            preferredRunway = 1; // RWY-B for departures
+    // One capacity scenario as a discrete-event model in virtual time. It
+    // uses the controller's schedules, airlines, runway queues, runway
+    // layout (repeated or cut to the scenario's runway count), dispatch
+    // ranking, runway selection, emergency reservations, runway slots, speed
+    // limits and lifecycle phase durations, but no threads or wall-clock
+    // waits, so thousands of scenarios run in seconds. Dispatch happens on
+    // events rather than every 500 ms, and gate capacity is not modelled.
+    ScenarioResult runCapacityScenario(int index, const MonteCarloConfig& config) {
+        std::mt19937_64 gen(config.seed * 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(index));
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        ScenarioResult result{};
+        result.runways = config.minRunways +
+                         static_cast<int>(gen() % static_cast<uint64_t>(config.maxRunways - config.minRunways + 1));
+        result.intervalScale = config.minIntervalScale + unit(gen) * (config.maxIntervalScale - config.minIntervalScale);
+        result.emergencyScale = config.minEmergencyScale + unit(gen) * (config.maxEmergencyScale - config.minEmergencyScale);
+
+        enum EventType { Spawn, RunwayRequest, SlotOpen };
+        struct Event {
+            int64_t timeMs;
+            EventType type;
+            size_t index;  // Schedule, flight or runway
+            bool operator>(const Event& other) const { return timeMs > other.timeMs; }
+        };
+        std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+        std::vector<std::unique_ptr<Flight>> scenarioFlights;
+        std::vector<int64_t> requestMs;
+        std::vector<RunwaySpec> layout;
+        for (int runwayID = 0; runwayID < result.runways; runwayID++) {
+            const Runway& runway = *runways[runwayID % runways.size()];
+            layout.push_back({runway.homeClass, runway.capabilities});
         }
-        
-        // Try preferred runway first
-        if (preferredRunway >= 0 && preferredRunway < runways.size()) {
-            std::lock_guard<std::mutex> lock(runways[preferredRunway]->runwayMutex);
-            if (!runways[preferredRunway]->occupied.load()) {
-                runways[preferredRunway]->occupied.store(true);
-                flight.runwayAssigned = preferredRunway;
-                flight.runwayOccupied = true;
-                
-                std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                std::cout << "\n=== RUNWAY ASSIGNMENT ===\n";
-                std::cout << "Flight: #" << flight.flightNumber << "\n";
-                std::cout << "Runway: " << runways[preferredRunway]->name << "\n";
-                std::cout << "============================\n";
-                return true;
+        const RunwayClassMasks masks = runwayClassMasks(layout);
+        std::vector<int64_t> runwayFreeAtMs(result.runways, 0);  // Next slot start, as in RunwayEtaModel
+        std::vector<int64_t> runwayExitAtMs(result.runways, 0);  // Granted runways count as free after this
+        std::vector<RunwayReservation> held(result.runways);
+        RunwayMask reserved = 0;
+        auto freeAtMs = [&runwayFreeAtMs](int runwayID) { return runwayFreeAtMs[runwayID]; };
+        std::vector<double> waits;
+        RunwayQueues queues;
+        double fines = 0.0;
+        const int64_t endMs = static_cast<int64_t>(config.hours * 3600.0 * 1000.0);
+        const auto epoch = std::chrono::system_clock::time_point{};
+
+        auto interArrivalMs = [&](size_t schedule) {
+            double meanMs = flightSchedules[schedule].intervalSeconds * result.intervalScale * 1000.0;
+            return static_cast<int64_t>(std::exponential_distribution<double>(1.0 / meanMs)(gen)) + 1;
+        };
+        // Milliseconds into a ground phase of the given length at which a
+        // fault occurs, or -1 if the phase completes
+        auto groundFaultMs = [&](const Flight& flight, int64_t lengthMs) -> int64_t {
+            auto faultMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                groundFaults.sample(flight.aircraftType, gen).after).count();
+            return faultMs < lengthMs ? faultMs : -1;
+        };
+        auto checkSpeed = [&](Flight& flight, FlightPhase phase, float speed) {
+            float permissible;
+            std::string reason;
+            if (!flight.violationActive && speedLimitViolation(phase, speed, permissible, reason)) {
+                flight.violationActive = true;
+                result.violations++;
+                fines += AVNGenerator::fineAmountFor(flight.aircraftType);
             }
-        }
-        
-        // If preferred runway not available, try alternatives (except for cargo)
-        if (flight.aircraftType != AircraftType::Cargo) {
-            for (int i = 0; i < runways.size(); i++) {
-                if (i != preferredRunway) {
-                    std::lock_guard<std::mutex> lock(runways[i]->runwayMutex);
-                    if (!runways[i]->occupied.load()) {
-                        runways[i]->occupied.store(true);
-                        flight.runwayAssigned = i;
-                        flight.runwayOccupied = true;
-                        
-                        std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                        std::cout << "\n=== OVERFLOW RUNWAY ASSIGNMENT ===\n";
-                        std::cout << "Flight: #" << flight.flightNumber << "\n";
-                        std::cout << "Runway: " << runways[i]->name << " (overflow)\n";
-                        std::cout << "============================\n";
-                        return true;
-                    }
+        };
+
+        // The controller's dispatchRunways over the scenario's layout
+        auto dispatch = [&](int64_t nowMs) {
+            while (true) {
+                QueueHeads heads;
+                size_t headCount = 0;
+                for (int c = 0; c < kRunwayClassCount; c++) {
+                    RunwayClass runwayClass = static_cast<RunwayClass>(c);
+                    if (!queues.empty(runwayClass)) heads[headCount++] = {queues.top(runwayClass), runwayClass};
+                }
+                sortQueueHeads(heads, headCount);
+
+                RunwayMask free = 0;
+                for (int runwayID = 0; runwayID < result.runways; runwayID++) {
+                    if (runwayExitAtMs[runwayID] <= nowMs) free |= RunwayMask{1} << runwayID;
+                }
+                Flight* best = nullptr;
+                RunwayClass bestClass = RunwayClass::Arrival;
+                int runwayID = -1;
+                for (size_t i = 0; i < headCount && runwayID < 0; i++) {
+                    auto [flight, runwayClass] = heads[i];
+                    RunwayMask allowed = allowedRunways(*flight, runwayClass, nowMs, masks, reserved, held);
+                    runwayID = pickRunway(*flight, allowed, free, masks.home[static_cast<int>(runwayClass)],
+                                          nowMs, freeAtMs);
+                    best = flight;
+                    bestClass = runwayClass;
+                }
+                if (runwayID < 0) return;
+
+                queues.pop(bestClass);
+                if (best->reservedRunway != -1) {
+                    held[best->reservedRunway] = RunwayReservation{};
+                    reserved &= ~(RunwayMask{1} << best->reservedRunway);
+                    best->reservedRunway = -1;
+                }
+                result.grants++;
+                waits.push_back((nowMs - requestMs[best->flightNumber]) / 1000.0);
+
+                if (runwayLeadMs(*best) > 0) {
+                    // Approach, landing roll to runway exit, then taxi to the gate
+                    checkSpeed(*best, FlightPhase::Approach, 400.0f + static_cast<float>(gen() % 201));
+                    checkSpeed(*best, FlightPhase::Landing, 240.0f);
+                    if (groundFaultMs(*best, 5000) >= 0) result.faults++;
+                } else {
+                    // Takeoff roll to liftoff, then climb and cruise off the runway
+                    checkSpeed(*best, FlightPhase::Climb, 250.0f + static_cast<float>(gen() % 213));
+                    checkSpeed(*best, FlightPhase::Cruise, 800.0f + static_cast<float>(gen() % 101));
                 }
+
+                // The next arrival may be cleared one approach before the slot ends
+                int64_t freeAt = nowMs + runwaySlotMs(*best);
+                runwayFreeAtMs[runwayID] = freeAt;
+                runwayExitAtMs[runwayID] = freeAt - separationBufferMs[static_cast<int>(bestClass)];
+                events.push({freeAt - std::chrono::duration_cast<std::chrono::milliseconds>(kApproachTime).count(),
+                             SlotOpen, static_cast<size_t>(runwayID)});
+                events.push({freeAt, SlotOpen, static_cast<size_t>(runwayID)});
             }
-        }
-        
-        return false;
-    }
+        };
 
-    void releaseRunway(int runwayID) {
-        if (runwayID >= 0 && runwayID < runways.size()) {
-            std::lock_guard<std::mutex> lock(runways[runwayID]->runwayMutex);
-            runways[runwayID]->occupied.store(false);
-            std::cout << "\n=== RUNWAY STATUS UPDATE ===\n";
-            std::cout << "Runway: " << runways[runwayID]->name << " released\n";
-            std::cout << "============================\n";
+        for (size_t i = 0; i < flightSchedules.size(); i++) {
+            events.push({interArrivalMs(i), Spawn, i});
         }
-    }
 
-    // Flight generation thread function
-    void flightGenerationThread() {
-        using namespace std::chrono;
-        auto startTime = steady_clock::now();
-        
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0.0, 1.0);
-        
-        std::vector<steady_clock::time_point> nextFlightTimes;
-        for (const auto& schedule : flightSchedules) {
-            nextFlightTimes.push_back(startTime);
-        }
-        
-        flightGenerationRunning = true;
-        static std::atomic<unsigned int> flightNumberCounter{1000};  // Changed to unsigned int
-        
-        while (flightGenerationRunning) {
-            auto now = steady_clock::now();
-            
-            // Check each flight schedule
-            for (size_t i = 0; i < flightSchedules.size(); i++) {
-                const auto& schedule = flightSchedules[i];
-                
-                if (now >= nextFlightTimes[i]) {
-                    bool isEmergency = (dis(gen) < schedule.emergencyProbability);
-                    
-                    std::vector<size_t> candidateAirlines;
-                    for (size_t j = 0; j < airlines.size(); j++) {
-                        // Select appropriate airline based on emergency type
-                        if (isEmergency) {
-                            // For military emergencies, only Pakistan Airforce
-                            if (schedule.emergencyType == EmergencyType::Military && 
-                                airlines[j].name == "Pakistan Airforce") {
-                                candidateAirlines.push_back(j);
-                            }
-                            // For medical emergencies, only AghaKhan Air Ambulance
-                            else if (schedule.emergencyType == EmergencyType::Medical && 
-                                   airlines[j].name == "AghaKhan Air Ambulance") {
-                                candidateAirlines.push_back(j);
-                            }
-                            // For other emergencies, any emergency airline
-                            else if (schedule.emergencyType != EmergencyType::Military && 
-                                   schedule.emergencyType != EmergencyType::Medical && 
-                                   airlines[j].type == AircraftType::Emergency) {
-                                candidateAirlines.push_back(j);
-                            }
-                        } else {
-                            // For non-emergency flights
-                            if (airlines[j].type != AircraftType::Emergency) {
-                                candidateAirlines.push_back(j);
+        while (!events.empty() && events.top().timeMs <= endMs) {
+            Event event = events.top();
+            events.pop();
+
+            switch (event.type) {
+                case Spawn: {
+                    const auto& schedule = flightSchedules[event.index];
+                    events.push({event.timeMs + interArrivalMs(event.index), Spawn, event.index});
+
+                    bool isEmergency = unit(gen) < std::min(1.0, schedule.emergencyProbability * result.emergencyScale);
+                    const std::vector<size_t>& candidates = airlineCandidates(event.index, isEmergency);
+                    if (candidates.empty()) break;
+                    Airline& airline = airlines[candidates[gen() % candidates.size()]];
+
+                    size_t flightIndex = scenarioFlights.size();
+                    scenarioFlights.push_back(std::make_unique<Flight>(
+                        static_cast<int>(flightIndex), &airline, airline.type, schedule.direction,
+                        epoch + std::chrono::milliseconds(event.timeMs),
+                        isEmergency ? schedule.emergencyType : EmergencyType::None));
+                    requestMs.push_back(0);
+                    result.flights++;
+
+                    if (schedule.direction == FlightDirection::NorthArrival ||
+                        schedule.direction == FlightDirection::SouthArrival) {
+                        // Minimum 10 s hold before asking for a runway; preempting
+                        // emergencies have a runway held for them meanwhile
+                        Flight& flight = *scenarioFlights.back();
+                        if (emergencyPolicy(flight.emergencyType).preempts) {
+                            RunwayMask open = masks.capable[static_cast<int>(RunwayQueues::classFor(flight))] & ~reserved;
+                            int chosen = earliestFreeRunway(open, freeAtMs);
+                            if (chosen != -1) {
+                                held[chosen] = {&flight, event.timeMs + 10000};
+                                reserved |= RunwayMask{1} << chosen;
+                                flight.reservedRunway = chosen;
                             }
                         }
-                    }
-                    
-                    if (!candidateAirlines.empty()) {
-                        size_t airlineIdx = candidateAirlines[dis(gen) * candidateAirlines.size()];
-                        Airline& airline = airlines[airlineIdx];
-                        
-                        EmergencyType emType = EmergencyType::None;
-                        if (isEmergency) {
-                            emType = schedule.emergencyType;
-                        }
-                        
-                        unsigned int flightNumber = flightNumberCounter++;
-                        
-                        auto newFlight = std::make_unique<Flight>(flightNumber, &airline, 
-                                                              airline.type, 
-                                                              schedule.direction, 
-                                                              system_clock::now(),
-                                                              emType);
-                        Flight* flightPtr = newFlight.get();
-                        
-                        {
-                            std::lock_guard<std::mutex> lock(flightsMutex);
-                            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-                            
-                            std::cout << "\n=== NEW FLIGHT ADDED ===\n";
-                            std::cout << "Flight: #" << flightPtr->flightNumber << "\n";
-                            std::cout << "Airline: " << flightPtr->airline->name << "\n";
-                            std::cout << "Type: " << flightPtr->getAircraftTypeString() << "\n";
-                            std::cout << "Direction: " << flightPtr->getDirectionString() << "\n";
-                            if (emType != EmergencyType::None) {
-                                std::cout << "Emergency: " << flightPtr->getEmergencyTypeString() << "\n";
-                            }
-                            std::cout << "============================\n";
-                            
-                            flights.push_back(std::move(newFlight));
-                            runwayQueue.push(flightPtr);
+                        events.push({event.timeMs + 10000, RunwayRequest, flightIndex});
+                    } else {
+                        // Turnaround at the gate, then a 5 s taxi, both with fault checks
+                        int64_t groundMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            turnaroundTime(*scenarioFlights.back())).count() + 5000;
+                        if (groundFaultMs(*scenarioFlights.back(), groundMs) >= 0) {
+                            result.faults++;
+                        } else {
+                            events.push({event.timeMs + groundMs, RunwayRequest, flightIndex});
                         }
-                        
-                        std::thread([this, flightPtr]() {
-                            this->flightThread(*flightPtr);
-                        }).detach();
                     }
-                    
-                    nextFlightTimes[i] = now + seconds(schedule.intervalSeconds);
+                    break;
                 }
+                case RunwayRequest:
+                    requestMs[event.index] = event.timeMs;
+                    queues.push(scenarioFlights[event.index].get());
+                    dispatch(event.timeMs);
+                    break;
+                case SlotOpen:
+                    dispatch(event.timeMs);
+                    break;
             }
-            
-            std::this_thread::sleep_for(milliseconds(100));
         }
+
+        result.queuedAtEnd = queues.size();
+        if (!waits.empty()) {
+            double total = 0.0;
+            for (double wait : waits) total += wait;
+            result.meanWaitSeconds = total / waits.size();
+            size_t p95 = static_cast<size_t>(0.95 * (waits.size() - 1));
+            std::nth_element(waits.begin(), waits.begin() + p95, waits.end());
+            result.p95WaitSeconds = waits[p95];
+        }
+        result.grantsPerHour = result.grants / config.hours;
+        result.violationsPerHour = result.violations / config.hours;
+        result.finesPerHour = fines / config.hours;
+        return result;
     }
 
-    // Runway management thread function
-    void runwayManagementThread() {
-        using namespace std::chrono;
-        auto lastAnalyticsTime = steady_clock::now();
-        
-        while (simulationRunning) {
-            auto now = steady_clock::now();
-            
-            // Display analytics every 30 seconds
-            if (duration_cast<seconds>(now - lastAnalyticsTime).count() >= 30) {
-                displayAnalytics();
-                lastAnalyticsTime = now;
-            }
-            
-            std::this_thread::sleep_for(milliseconds(500));
-            
-            // Process runway queue
-            std::lock_guard<std::mutex> lock(flightsMutex);
-            while (!runwayQueue.empty()) {
-                Flight* flight = runwayQueue.top();
-                
-                if (flight->runwayAssigned == -1) {
-                    if (assignRunway(*flight)) {
-                        runwayQueue.pop();
-                    } else {
-                        // Couldn't assign runway, keep in queue
-                        flight->estimatedWaitTime += 500;
-                        break;
-                    }
-                } else {
-                    runwayQueue.pop();
+    // Run every scenario across a pool of worker threads
+    std::vector<ScenarioResult> runMonteCarlo(const MonteCarloConfig& config) {
+        std::vector<ScenarioResult> results(config.scenarios);
+        std::atomic<int> nextScenario(0);
+        int threadCount = config.threads > 0 ? config.threads
+                                             : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threadCount; t++) {
+            workers.emplace_back([&]() {
+                for (int i = nextScenario++; i < config.scenarios; i = nextScenario++) {
+                    results[i] = runCapacityScenario(i, config);
                 }
-            }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return results;
+    }
+
+    // Mean and 95% confidence half-width of a metric over scenarios
+    template <typename Metric>
+    static std::pair<double, double> confidenceInterval(const std::vector<const ScenarioResult*>& group,
+                                                        Metric metric) {
+        if (group.empty()) return {0.0, 0.0};
+        double sum = 0.0;
+        for (const auto* result : group) sum += metric(*result);
+        double mean = sum / group.size();
+        if (group.size() < 2) return {mean, 0.0};
+        double squares = 0.0;
+        for (const auto* result : group) {
+            double d = metric(*result) - mean;
+            squares += d * d;
         }
+        return {mean, 1.96 * std::sqrt(squares / (group.size() - 1)) / std::sqrt(static_cast<double>(group.size()))};
     }
 
-    std::string flightPhaseToString(FlightPhase phase) {
-        switch (phase) {
-            case FlightPhase::Holding: return "Holding";
-            case FlightPhase::Approach: return "Approach";
-            case FlightPhase::Landing: return "Landing";
-            case FlightPhase::Taxi: return "Taxi";
-            case FlightPhase::AtGate: return "At Gate";
-            case FlightPhase::TakeoffRoll: return "Takeoff Roll";
-            case FlightPhase::Climb: return "Climb";
-            case FlightPhase::Cruise: return "Cruise";
-            case FlightPhase::Departure: return "Departure";
-            default: return "Unknown";
+    void printMonteCarloReport(const MonteCarloConfig& config, const std::vector<ScenarioResult>& results,
+                               double wallSeconds) const {
+        std::map<int, std::vector<const ScenarioResult*>> byRunways;
+        for (const auto& result : results) {
+            byRunways[result.runways].push_back(&result);
         }
-    }
 
-    // Analytics functions
-    void displayAnalytics() {
-        std::lock_guard<std::mutex> lock(flightsMutex);
-        std::lock_guard<std::mutex> avnLock(avnMutex);
-        std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-        
-        // Get current time
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        
-        std::cout << "\n=== ATC DASHBOARD ===\n";
-        std::cout << "Time: " << std::put_time(std::localtime(&time), "%H:%M:%S") << "\n";
+        auto cell = [](std::pair<double, double> value, int precision) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(precision) << value.first << " ±" << value.second;
+            return out.str();
+        };
 
-        // Count active flights and their states
-        int activeFlights = 0;
-        int activeViolations = 0;
-        int flightsInAir = 0;
-        int flightsOnGround = 0;
-        int emergencyFlights = 0;
-        std::map<std::string, int> airlineCounts;
-        std::map<FlightPhase, int> phaseCounts;
-        
-        for (const auto& flight : flights) {
-            activeFlights++;
-            if (flight->violationActive) activeViolations++;
-            if (flight->emergencyType != EmergencyType::None) emergencyFlights++;
-            
-            if (flight->phase == FlightPhase::Holding || 
-                flight->phase == FlightPhase::Approach || 
-                flight->phase == FlightPhase::Landing ||
-                flight->phase == FlightPhase::Climb || 
-                flight->phase == FlightPhase::Cruise) {
-                flightsInAir++;
-            } else {
-                flightsOnGround++;
+        ProfiledLock consoleLock(g_console_mutex);
+        std::cout << "\n=== MONTE CARLO CAPACITY REPORT ===\n";
+        std::cout << "Scenarios: " << results.size() << " x " << config.hours << " h simulated, seed "
+                  << config.seed << ", " << std::fixed << std::setprecision(1) << wallSeconds << " s wall\n";
+        std::cout << "Schedule interval x" << config.minIntervalScale << "-" << config.maxIntervalScale
+                  << ", emergency probability x" << config.minEmergencyScale << "-" << config.maxEmergencyScale
+                  << " (mean ±95% CI)\n";
+        std::cout << std::left << std::setw(9) << "Runways" << std::setw(7) << "Runs"
+                  << std::setw(18) << "Grants/h" << std::setw(18) << "MeanWait(s)"
+                  << std::setw(18) << "P95Wait(s)" << std::setw(16) << "Violations/h"
+                  << std::setw(13) << "Faults/h" << "Saturated\n";
+        for (const auto& entry : byRunways) {
+            const auto& group = entry.second;
+            size_t saturated = 0;
+            for (const auto* result : group) {
+                // A queue still holding over 5% of the flights means demand outran the runways
+                if (result->queuedAtEnd * 20 > result->flights) saturated++;
             }
-            
-            airlineCounts[flight->airline->name]++;
-            phaseCounts[flight->phase]++;
+            std::cout << std::left << std::setw(9) << entry.first << std::setw(7) << group.size()
+                      << std::setw(18) << cell(confidenceInterval(group, [](const ScenarioResult& r) { return r.grantsPerHour; }), 1)
+                      << std::setw(18) << cell(confidenceInterval(group, [](const ScenarioResult& r) { return r.meanWaitSeconds; }), 1)
+                      << std::setw(18) << cell(confidenceInterval(group, [](const ScenarioResult& r) { return r.p95WaitSeconds; }), 1)
+                      << std::setw(16) << cell(confidenceInterval(group, [](const ScenarioResult& r) { return r.violationsPerHour; }), 1)
+                      << std::setw(13) << cell(confidenceInterval(group, [&](const ScenarioResult& r) { return r.faults / config.hours; }), 1)
+                      << std::setprecision(0) << 100.0 * saturated / group.size() << "%\n";
         }
-        
-        // Display counts
-        std::cout << "Active Flights: " << activeFlights << "\n";
-        std::cout << "In Air: " << flightsInAir << " | On Ground: " << flightsOnGround << "\n";
-        std::cout << "Emergency Flights: " << emergencyFlights << "\n";
-        std::cout << "Active Violations: " << activeViolations << "\n";
-        
-        // Display runway status
-        std::cout << "RUNWAY STATUS:\n";
-        for (const auto& runway : runways) {
-            std::cout << "  " << std::left << std::setw(30) << runway->name 
-                      << (runway->occupied.load() ? "OCCUPIED" : "AVAILABLE") << "\n";
-        }
-        
-        // Display airline activity
-        std::cout << "AIRLINE ACTIVITY:\n";
-        for (const auto& entry : airlineCounts) {
-            std::cout << "  " << std::left << std::setw(20) << entry.first 
-                      << ": " << entry.second << " flights\n";
+
+        std::vector<const ScenarioResult*> all;
+        for (const auto& result : results) all.push_back(&result);
+        auto fines = confidenceInterval(all, [](const ScenarioResult& r) { return r.finesPerHour; });
+        std::cout << "Fines: PKR " << std::setprecision(0) << fines.first << " ±" << fines.second << " per hour\n";
+        std::cout << "============================\n";
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+
+    // AVN analytics over the full history in shared memory
+    void printAVNAnalytics() {
+        using namespace std::chrono;
+        ProfiledLock avnLock(avnMutex);
+        avnGenerator->syncAnalytics(avnAnalytics);
+
+        auto queryStart = steady_clock::now();
+        time_t now = system_clock::to_time_t(system_clock::now());
+        std::tm localNow = *std::localtime(&now);
+        std::vector<double> outstanding = avnAnalytics.outstandingFinesByAirline();
+        std::vector<uint64_t> byPhaseHour = avnAnalytics.violationsByPhaseAndHour(localNow.tm_gmtoff);
+        uint64_t overdue = avnAnalytics.overdueCount(now);
+        double queryMs = duration<double, std::milli>(steady_clock::now() - queryStart).count();
+
+        ProfiledLock consoleLock(g_console_mutex);
+        std::ios_base::fmtflags savedFlags = std::cout.flags();
+        std::streamsize savedPrecision = std::cout.precision();
+        std::cout << "\n=== AVN ANALYTICS ===\n";
+        std::cout << "AVNs: " << avnAnalytics.size() << " | Overdue: " << overdue << "\n";
+        std::cout << "OUTSTANDING FINES:\n";
+        for (size_t i = 0; i < outstanding.size(); i++) {
+            std::cout << "  " << std::left << std::setw(24) << avnAnalytics.airlines()[i]
+                      << ": PKR " << std::fixed << std::setprecision(2) << outstanding[i] << "\n";
         }
-        
-        // Display phase distribution
-        std::cout << "FLIGHT PHASES:\n";
-        for (const auto& entry : phaseCounts) {
-            std::cout << "  " << std::left << std::setw(20) << flightPhaseToString(entry.first) 
-                      << ": " << entry.second << "\n";
+        std::cout << "VIOLATIONS BY PHASE AND HOUR:\n";
+        for (int p = 0; p < kFlightPhaseCount; p++) {
+            for (int hour = 0; hour < 24; hour++) {
+                uint64_t count = byPhaseHour[p * 24 + hour];
+                if (count > 0) {
+                    std::cout << "  " << std::left << std::setw(14) << kFlightPhaseNames[p]
+                              << std::right << std::setw(2) << std::setfill('0') << hour << ":00"
+                              << std::setfill(' ') << "  " << count << "\n";
+                }
+            }
         }
-        
-        std::cout << "============================\n\n";
+        std::cout << "Query time: " << std::setprecision(3) << queryMs << " ms\n";
+        std::cout << "============================\n";
+        std::cout.flags(savedFlags);
+        std::cout.precision(savedPrecision);
     }
 
     // Start simulation
     void startSimulation() {
         simulationRunning = true;
         flightGenerationRunning = true;
-        simulationStartTime = std::chrono::steady_clock::now();
+        simulationStartTime = std::chrono::steady_clock::now() - toWallTime(restoredElapsed);
+        gateAllocator->open(simulationTimeMs());
+        
+        // Resume lifecycles of flights restored from a checkpoint
+        {
+            ProfiledLock lock(flightsMutex);
+            for (auto& flight : flights) {
+                if (!flight->lifecycleComplete && !flight->hasFault) {
+                    spawnLifecycle(*flight);
+                }
+            }
+        }
         
         // Start flight generation thread
         std::thread generationThread(&ATCSController::flightGenerationThread, this);
         
         // Start runway management thread
         std::thread runwayThread(&ATCSController::runwayManagementThread, this);
+
+        // Start airspace separation thread
+        std::thread airspace(&ATCSController::airspaceThread, this);
         
         // Main simulation loop
         auto lastAnalyticsTime = simulationStartTime;
@@ -1272,12 +7620,12 @@ public:
         
         while (simulationRunning) {
             auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - simulationStartTime).count();
+            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(toSimTime(now - simulationStartTime)).count();
             
             // Check for simulation end
             if (elapsed >= simulationDuration.count()) {
                 {
-                    std::lock_guard<std::mutex> consoleLock(g_console_mutex);
+                    ProfiledLock consoleLock(g_console_mutex);
                     std::cout << "\n=== SIMULATION TIME COMPLETED ===\n";
                     std::cout << "Total simulation time: " << elapsed << " seconds\n";
                     std::cout << "============================\n";
@@ -1291,15 +7639,19 @@ public:
             
             // Display analytics every 30 seconds and at the end
             int currentPeriod = elapsed / 30;
-            if (currentPeriod > lastAnalyticsPeriod) {
+            if (!headless && currentPeriod > lastAnalyticsPeriod) {
                 displayAnalytics();
                 lastAnalyticsPeriod = currentPeriod;
                 lastAnalyticsTime = now;
             }
             
             // Sleep to prevent high CPU usage
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                toWallTime(std::chrono::milliseconds(100)), std::chrono::milliseconds(100)));
         }
+        // Less than the full duration if a shutdown command ended the run
+        auto simulatedSeconds = std::min(simulationDuration, std::chrono::duration_cast<std::chrono::seconds>(
+            toSimTime(std::chrono::steady_clock::now() - simulationStartTime)));
         
         // Wait for threads to finish
         if (generationThread.joinable()) {
@@ -1308,32 +7660,768 @@ public:
         if (runwayThread.joinable()) {
             runwayThread.join();
         }
+        if (airspace.joinable()) {
+            airspace.join();
+        }
+        if (g_lowLatency.enabled()) {
+            printDispatchLatency();
+        }
+        printEmergencySlo();
+        
+        // Release pending phase delays and wait for every lifecycle to finish
+        for (auto handle : gateAllocator->cancelWaiters()) {
+            lifecycleExecutor->post(handle);
+        }
+        lifecycleTimer->stop();
+        {
+            // A control-socket inject that saw the run still going has
+            // spawned its lifecycle by the time this lock is free
+            ProfiledLock lock(flightsMutex);
+        }
+        while (activeLifecycles.load() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        lifecycleExecutor->shutdown();
+        events.flush();
+        if (telemetry) {
+            telemetry->close();
+        }
+        if (ipcPipeline) {
+            ipcPipeline->shutdown();
+            ipcPipeline->printReport();
+        }
+        events.printReport();
         
-        // Display final analytics
+        // Display final analytics and the report over the whole run
         displayAnalytics();
+        writeRunReport();
+        g_tracer.finish();
         
         // Show completion message
         {
-            std::lock_guard<std::mutex> consoleLock(g_console_mutex);
-            std::cout << "\nSimulation completed after " << simulationDuration.count() << " seconds.\n";
+            ProfiledLock consoleLock(g_console_mutex);
+            std::cout << "\nSimulation completed after " << simulatedSeconds.count() << " seconds.\n";
             std::cout << "All threads terminated successfully.\n";
         }
     }
 };
 
-int main() {
+// Local control socket. Scripts connect to a Unix-domain stream socket and
+// send newline-terminated commands; each command gets exactly one response
+// line, "OK ..." or "ERR ...", in request order. Clients may pipeline: write
+// many commands without waiting, and every complete command in one read is
+// answered in one write. A single thread multiplexes all clients with poll(),
+// and each command takes only the short lock its query needs, so the
+// simulation threads never wait on a client.
+//
+//   ping                                     OK pong
+//   status                                   OK running=1 sim_ms=... flights=...
+//   avns AIRLINE                             OK N id:flight:fine:paid ...
+//   pay AVN_ID AMOUNT [KEY]                  OK queued KEY | ERR key-reused
+//   payment KEY                              OK pending | OK settled ... | ERR unknown-key
+//   flight NUMBER                            OK phase=... speed=... runway=... eta_ms=... avns=...
+//   inject DIRECTION EMERGENCY AIRLINE       OK flight N
+//   rate PER_HOUR                            OK rate PER_HOUR (0 restores the schedules)
+//   shutdown                                 OK stopping
+//   quit                                     closes the connection
+class ControlServer {
+private:
+    static const size_t kReadChunk = 64 * 1024;
+    static const size_t kMaxPendingOutput = 1 << 20;  // Stop reading a client that is not reading replies
+
+    struct Client {
+        int fd;
+        std::string input;
+        std::string output;
+        bool closing;
+    };
+
+    std::string path;
+    ATCSController& atcs;
+    PaymentQueue& payments;
+    bip::managed_shared_memory segment;
+    SharedAVNVector* avnVector;
+    ProfiledMutex<bip::named_mutex> namedMutex;
+    int listenFd;
+    int wakePipe[2];
+    std::vector<Client> clients;
+    std::thread serverThread;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> commandsServed;
+
+    static bool setNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    static bool parseDirection(const std::string& text, FlightDirection& direction) {
+        if (text == "north") direction = FlightDirection::NorthArrival;
+        else if (text == "south") direction = FlightDirection::SouthArrival;
+        else if (text == "east") direction = FlightDirection::EastDeparture;
+        else if (text == "west") direction = FlightDirection::WestDeparture;
+        else return false;
+        return true;
+    }
+
+    static bool parseEmergency(const std::string& text, EmergencyType& type) {
+        if (text == "none") type = EmergencyType::None;
+        else if (text == "military") type = EmergencyType::Military;
+        else if (text == "medical") type = EmergencyType::Medical;
+        else if (text == "fuel") type = EmergencyType::DiversionOrLowFuel;
+        else if (text == "vip") type = EmergencyType::VIP;
+        else return false;
+        return true;
+    }
+
+    static const char* outcomeName(PaymentOutcome outcome) {
+        switch (outcome) {
+            case PaymentOutcome::Settled: return "settled";
+            case PaymentOutcome::Declined: return "declined";
+            case PaymentOutcome::AlreadyPaid: return "already-paid";
+            case PaymentOutcome::NotFound: return "not-found";
+            case PaymentOutcome::KeyReused: return "key-reused";
+        }
+        return "unknown";
+    }
+
+    // Rest of the line after the leading tokens, for names with spaces
+    static std::string remainder(std::istringstream& in) {
+        std::string rest;
+        std::getline(in >> std::ws, rest);
+        return rest;
+    }
+
+    void listAVNs(const std::string& airlineName, std::ostringstream& out) {
+        std::ostringstream entries;
+        entries << std::fixed << std::setprecision(2);
+        size_t count = 0;
+        {
+            ProfiledLock lock(namedMutex);
+            if (avnVector) {
+                for (const auto& avn : *avnVector) {
+                    if (strcmp(avn.airlineName, airlineName.c_str()) != 0) continue;
+                    entries << " " << avn.avnID << ":" << avn.flightNumber << ":" << avn.fineAmount
+                            << ":" << (avn.paymentStatus ? "paid" : "unpaid");
+                    count++;
+                }
+            }
+        }
+        out << "OK " << count << entries.str();
+    }
+
+    // One command line to one response line, without the newline
+    std::string execute(const std::string& line, bool& closeClient) {
+        std::istringstream in(line);
+        std::ostringstream out;
+        std::string verb;
+        in >> verb;
+
+        if (verb == "ping") {
+            out << "OK pong";
+        } else if (verb == "status") {
+            ATCSController::Status status = atcs.status();
+            out << "OK running=" << status.running << " sim_ms=" << status.simulationMs
+                << " flights=" << status.flights << " airborne=" << status.airborne
+                << " queued=" << status.queued[0] << "/" << status.queued[1] << "/" << status.queued[2]
+                << " grants=" << status.grants << " movements=" << status.movements
+                << " rate=" << status.offeredRatePerHour;
+        } else if (verb == "avns") {
+            std::string airlineName = remainder(in);
+            if (airlineName.empty()) return "ERR usage: avns AIRLINE";
+            listAVNs(airlineName, out);
+        } else if (verb == "pay") {
+            int avnID;
+            double amount;
+            if (!(in >> avnID >> amount)) return "ERR usage: pay AVN_ID AMOUNT [KEY]";
+            std::string key;
+            if (!(in >> key)) {
+                key = "pay-" + std::to_string(avnID) + "-" + std::to_string(std::llround(amount * 100));
+            }
+            if (payments.submit({key, avnID, amount}, nullptr) == PaymentQueue::Submitted::KeyReused) {
+                return "ERR key-reused";
+            }
+            out << "OK queued " << key;
+        } else if (verb == "payment") {
+            std::string key;
+            if (!(in >> key)) return "ERR usage: payment KEY";
+            PaymentResult result{};
+            bool done = false;
+            if (!payments.lookup(key, result, done)) return "ERR unknown-key";
+            if (!done) return "OK pending";
+            out << "OK " << outcomeName(result.outcome) << " avn=" << result.avnID;
+            if (!result.chargeID.empty()) out << " charge=" << result.chargeID;
+        } else if (verb == "flight") {
+            int flightNumber;
+            if (!(in >> flightNumber)) return "ERR usage: flight NUMBER";
+            FlightStatus status;
+            if (!atcs.flightStatus(flightNumber, status)) return "ERR unknown flight";
+            int64_t etaMs = atcs.expectedRunwayWaitMs(status);
+            std::string phase = kFlightPhaseNames[static_cast<int>(status.phase)];
+            std::replace(phase.begin(), phase.end(), ' ', '-');
+            out << "OK phase=" << phase
+                << " speed=" << status.speed << " runway=" << status.runwayAssigned
+                << " gate=" << status.gateAssigned << " queued=" << status.inRunwayQueue
+                << " eta_ms=" << etaMs << " faulted=" << status.faulted
+                << " complete=" << status.complete << " avns=";
+            for (size_t i = 0; i < status.avnIDs.size(); i++) {
+                out << (i ? "," : "") << status.avnIDs[i];
+            }
+            if (status.avnIDs.empty()) out << "-";
+        } else if (verb == "inject") {
+            std::string directionText;
+            std::string emergencyText;
+            FlightDirection direction;
+            EmergencyType emType;
+            if (!(in >> directionText >> emergencyText) || !parseDirection(directionText, direction) ||
+                !parseEmergency(emergencyText, emType)) {
+                return "ERR usage: inject north|south|east|west none|military|medical|fuel|vip AIRLINE";
+            }
+            int number = atcs.injectFlight(remainder(in), direction, emType);
+            if (number == -2) return "ERR not running";
+            if (number < 0) return "ERR unknown airline";
+            out << "OK flight " << number;
+        } else if (verb == "rate") {
+            double rate;
+            if (!(in >> rate) || rate < 0.0) return "ERR usage: rate PER_HOUR";
+            atcs.setOfferedRate(rate);
+            out << "OK rate " << rate;
+        } else if (verb == "shutdown") {
+            atcs.stopSimulation();
+            out << "OK stopping";
+        } else if (verb == "quit") {
+            closeClient = true;
+            out << "OK bye";
+        } else if (verb.empty()) {
+            return "ERR empty command";
+        } else {
+            return "ERR unknown command: " + verb;
+        }
+        return out.str();
+    }
+
+    // Answer every complete line buffered for a client
+    void serveInput(Client& client) {
+        size_t start = 0;
+        size_t newline;
+        while (!client.closing && (newline = client.input.find('\n', start)) != std::string::npos) {
+            std::string line = client.input.substr(start, newline - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            start = newline + 1;
+            client.output += execute(line, client.closing);
+            client.output += '\n';
+            commandsServed++;
+        }
+        client.input.erase(0, start);
+    }
+
+    // False once the peer has gone
+    bool readClient(Client& client) {
+        char buffer[kReadChunk];
+        while (true) {
+            ssize_t n = ::read(client.fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                client.input.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            if (n == 0) return false;
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+    }
+
+    bool writeClient(Client& client) {
+        while (!client.output.empty()) {
+            ssize_t n = ::send(client.fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+            if (n > 0) {
+                client.output.erase(0, static_cast<size_t>(n));
+                continue;
+            }
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        }
+        return true;
+    }
+
+    void acceptClients() {
+        while (true) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) return;
+            setNonBlocking(fd);
+            clients.push_back({fd, {}, {}, false});
+        }
+    }
+
+    void serverLoop() {
+        g_tracer.nameThread("control-socket");
+        AllocTracker::tagThread(AllocSubsystem::Control);
+        std::vector<pollfd> fds;
+        while (running) {
+            fds.clear();
+            fds.push_back({listenFd, POLLIN, 0});
+            fds.push_back({wakePipe[0], POLLIN, 0});
+            for (const auto& client : clients) {
+                short events = client.output.size() < kMaxPendingOutput ? POLLIN : 0;
+                if (!client.output.empty()) events |= POLLOUT;
+                fds.push_back({client.fd, events, 0});
+            }
+            if (::poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (fds[1].revents & POLLIN) {
+                char drain[64];
+                while (::read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+            }
+
+            for (size_t i = 0; i < clients.size(); i++) {
+                Client& client = clients[i];
+                short revents = fds[i + 2].revents;
+                bool alive = true;
+                if (revents & POLLIN) {
+                    alive = readClient(client);
+                    serveInput(client);
+                }
+                if (revents & (POLLERR | POLLNVAL)) {
+                    alive = false;
+                }
+                if (!client.output.empty()) {
+                    alive = writeClient(client) && alive;
+                }
+                if (!alive || (client.closing && client.output.empty())) {
+                    ::close(client.fd);
+                    client.fd = -1;
+                }
+            }
+            clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                         [](const Client& client) { return client.fd < 0; }),
+                          clients.end());
+
+            if (fds[0].revents & POLLIN) {
+                acceptClients();
+            }
+        }
+    }
+
+public:
+    ControlServer(const std::string& socketPath, ATCSController& controller, PaymentQueue& paymentQueue)
+        : path(socketPath), atcs(controller), payments(paymentQueue),
+          segment(bip::open_or_create, "AVNSharedMemory", kAVNSegmentSize),
+          namedMutex("AVNMutex", bip::open_or_create, "AVNMutex"),
+          listenFd(-1), wakePipe{-1, -1}, running(false), commandsServed(0)
+    {
+        avnVector = segment.find<SharedAVNVector>("AVNVector").first;
+    }
+
+    ~ControlServer() {
+        stop();
+    }
+
+    bool start() {
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path)) {
+            std::cerr << "Control socket path too long: " << path << std::endl;
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        ::unlink(path.c_str());
+
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listenFd, 64) != 0 || !setNonBlocking(listenFd) || ::pipe(wakePipe) != 0) {
+            std::cerr << "Failed to open control socket " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        setNonBlocking(wakePipe[0]);
+
+        running = true;
+        serverThread = std::thread(&ControlServer::serverLoop, this);
+        std::cout << "Control socket listening on " << path << std::endl;
+        return true;
+    }
+
+    void stop() {
+        if (running.exchange(false)) {
+            char wake = 1;
+            ssize_t ignored = ::write(wakePipe[1], &wake, 1);
+            (void)ignored;
+        }
+        if (serverThread.joinable()) {
+            serverThread.join();
+        }
+        for (auto& client : clients) {
+            ::close(client.fd);
+        }
+        clients.clear();
+        if (listenFd >= 0) ::close(listenFd);
+        if (wakePipe[0] >= 0) ::close(wakePipe[0]);
+        if (wakePipe[1] >= 0) ::close(wakePipe[1]);
+        listenFd = wakePipe[0] = wakePipe[1] = -1;
+        ::unlink(path.c_str());
+    }
+
+    uint64_t served() const { return commandsServed.load(); }
+};
+
+// Drive a running control socket as a script would: pipeline `count`
+// commands in batches and time the round trips
+void runControlBenchmark(const std::string& path, uint64_t count) {
+    constexpr uint64_t kBatch = 256;
+    const char* const commands[] = {"flight 1000\n", "status\n", "avns PIA\n", "payment bench-missing\n"};
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Failed to connect to control socket " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return;
+    }
+
+    std::vector<int64_t> batchNs;
+    uint64_t errors = 0;
+    std::string request;
+    std::string reply;
+    char buffer[64 * 1024];
+    int64_t started = monotonicNs();
+    for (uint64_t sent = 0; sent < count; sent += kBatch) {
+        uint64_t batch = std::min(kBatch, count - sent);
+        request.clear();
+        for (uint64_t i = 0; i < batch; i++) {
+            request += commands[(sent + i) % 4];
+        }
+        int64_t batchStart = monotonicNs();
+        if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) break;
+
+        uint64_t lines = 0;
+        reply.clear();
+        while (lines < batch) {
+            ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n <= 0) break;
+            reply.append(buffer, static_cast<size_t>(n));
+            lines += std::count(buffer, buffer + n, '\n');
+        }
+        for (size_t pos = 0; pos < reply.size(); pos = reply.find('\n', pos) + 1) {
+            if (reply.compare(pos, 3, "ERR") == 0) errors++;
+        }
+        batchNs.push_back(monotonicNs() - batchStart);
+        if (lines < batch) break;
+    }
+    double wallSeconds = (monotonicNs() - started) / 1e9;
+    ::close(fd);
+
+    std::sort(batchNs.begin(), batchNs.end());
+    auto percentileMs = [&batchNs](double p) {
+        if (batchNs.empty()) return 0.0;
+        size_t index = std::min(batchNs.size() - 1, static_cast<size_t>(p * (batchNs.size() - 1) + 0.5));
+        return batchNs[index] / 1e6;
+    };
+
+    ProfiledLock consoleLock(g_console_mutex);
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "\n=== CONTROL SOCKET BENCHMARK ===\n";
+    std::cout << "Commands: " << count << " in batches of " << kBatch
+              << " | Error replies: " << errors << " (1 in 4 queries an unknown key)\n";
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "Throughput: " << (wallSeconds > 0 ? count / wallSeconds : 0.0) << " commands/s\n";
+    std::cout << std::setprecision(2);
+    std::cout << "Batch round trip p50/p99: " << percentileMs(0.50) << " / " << percentileMs(0.99) << " ms\n";
+    std::cout << "============================\n";
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+int main(int argc, char* argv[]) {
+    AllocTracker::tagThread(AllocSubsystem::Main);
+
+    // Command line options
+    std::string restorePath;
+    std::string telemetryPath;
+    std::string tracePath;
+    std::string role;
+    int gateCount = 0;
+    int portalCount = 1;
+    bool multiProcess = false;
+    bool quiet = false;
+    uint64_t ipcBenchCount = 0;
+    uint64_t paymentBenchCount = 0;
+    int paymentWorkers = 4;
+    std::string controlSocketPath;
+    uint64_t controlBenchCount = 0;
+    std::chrono::milliseconds gatewayLatency(2000);
+    bool allocProfile = false;
+    std::string runReportPath;
+    uint64_t reportBenchCount = 0;
+    double allocBudget = 0.0;
+    bool stressMode = false;
+    SaturationConfig stressConfig;
+    MonteCarloConfig monteCarloConfig;
+    bool monteCarloMode = false;
+    std::vector<std::string> faultRates;
+    std::vector<std::string> runwayBuffers;
+    std::string runwayLayout;
+    ArrivalProcess arrivalProcess = ArrivalProcess::Scheduled;
+    double arrivalRate = 0.0;
+    double burstSize = 1.0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--restore" && hasValue) {
+            restorePath = argv[++i];
+        } else if (arg == "--stress") {
+            stressMode = true;
+        } else if (arg == "--start-rate" && hasValue) {
+            stressConfig.startRatePerHour = std::stod(argv[++i]);
+        } else if (arg == "--rate-step" && hasValue) {
+            stressConfig.rateStepPerHour = std::stod(argv[++i]);
+        } else if (arg == "--step-minutes" && hasValue) {
+            stressConfig.stepMinutes = std::stoi(argv[++i]);
+        } else if (arg == "--max-steps" && hasValue) {
+            stressConfig.maxSteps = std::stoi(argv[++i]);
+        } else if (arg == "--time-scale" && hasValue) {
+            stressConfig.timeScale = std::stod(argv[++i]);
+        } else if (arg == "--monte-carlo" && hasValue) {
+            monteCarloMode = true;
+            monteCarloConfig.scenarios = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--mc-hours" && hasValue) {
+            monteCarloConfig.hours = std::stod(argv[++i]);
+        } else if (arg == "--mc-seed" && hasValue) {
+            monteCarloConfig.seed = std::stoull(argv[++i]);
+        } else if (arg == "--mc-runways" && hasValue) {
+            // Either a single count or a range such as 2-6, at most kMaxRunways
+            std::string range = argv[++i];
+            size_t dash = range.find('-');
+            monteCarloConfig.minRunways = std::clamp(std::stoi(range.substr(0, dash)), 1, kMaxRunways);
+            monteCarloConfig.maxRunways = dash == std::string::npos
+                ? monteCarloConfig.minRunways
+                : std::clamp(std::stoi(range.substr(dash + 1)), monteCarloConfig.minRunways, kMaxRunways);
+        } else if (arg == "--mc-threads" && hasValue) {
+            monteCarloConfig.threads = std::stoi(argv[++i]);
+        } else if (arg == "--arrivals" && hasValue) {
+            std::string process = argv[++i];
+            if (process == "scheduled") {
+                arrivalProcess = ArrivalProcess::Scheduled;
+            } else if (process == "poisson") {
+                arrivalProcess = ArrivalProcess::Poisson;
+            } else if (process == "bursty") {
+                arrivalProcess = ArrivalProcess::Bursty;
+            } else {
+                std::cerr << "Unknown arrival process: " << process << std::endl;
+                return 1;
+            }
+        } else if (arg == "--arrival-rate" && hasValue) {
+            arrivalRate = std::stod(argv[++i]);  // Flights per simulated hour
+        } else if (arg == "--burst-size" && hasValue) {
+            burstSize = std::stod(argv[++i]);
+        } else if (arg == "--pin-dispatcher" && hasValue) {
+            g_lowLatency.dispatcherCore = std::stoi(argv[++i]);
+        } else if (arg == "--pin-workers" && hasValue) {
+            g_lowLatency.workerCore = std::stoi(argv[++i]);
+        } else if (arg == "--busy-poll") {
+            g_lowLatency.busyPoll = true;
+        } else if (arg == "--sched-fifo" && hasValue) {
+            g_lowLatency.realtimePriority = std::stoi(argv[++i]);
+        } else if (arg == "--dispatch-latency") {
+            g_lowLatency.reportLatency = true;
+        } else if (arg == "--runway-buffer" && hasValue) {
+            runwayBuffers.push_back(argv[++i]);
+        } else if (arg == "--runways" && hasValue) {
+            runwayLayout = argv[++i];
+        } else if (arg == "--fault-rate" && hasValue) {
+            faultRates.push_back(argv[++i]);
+        } else if (arg == "--gates" && hasValue) {
+            gateCount = std::stoi(argv[++i]);
+        } else if (arg == "--telemetry" && hasValue) {
+            telemetryPath = argv[++i];
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (arg == "--multiprocess") {
+            multiProcess = true;
+        } else if (arg == "--portals" && hasValue) {
+            portalCount = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--ipc-bench" && hasValue) {
+            ipcBenchCount = std::stoull(argv[++i]);
+            multiProcess = true;
+            quiet = true;
+        } else if (arg == "--payment-workers" && hasValue) {
+            paymentWorkers = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--gateway-latency" && hasValue) {
+            gatewayLatency = std::chrono::milliseconds(std::max(0, std::stoi(argv[++i])));
+        } else if (arg == "--payment-bench" && hasValue) {
+            paymentBenchCount = std::stoull(argv[++i]);
+        } else if (arg == "--control-socket" && hasValue) {
+            controlSocketPath = argv[++i];
+        } else if (arg == "--control-bench" && hasValue) {
+            controlBenchCount = std::stoull(argv[++i]);
+        } else if (arg == "--report" && hasValue) {
+            runReportPath = argv[++i];
+        } else if (arg == "--report-bench" && hasValue) {
+            reportBenchCount = std::stoull(argv[++i]);
+        } else if (arg == "--alloc-profile") {
+            allocProfile = true;
+        } else if (arg == "--alloc-budget" && hasValue) {
+            // Allocations allowed per flight (or per benchmark operation)
+            allocProfile = true;
+            allocBudget = std::stod(argv[++i]);
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else if (arg == "--role" && hasValue) {
+            // Set by the controller when it spawns the other processes
+            role = argv[++i];
+        } else if (arg == "--telemetry-summary" && hasValue) {
+            // Offline analysis only; no simulation is started
+            return printTelemetrySummary(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    
+    if (role == "avn") {
+        return runAVNProcess(portalCount, quiet);
+    } else if (role == "portal") {
+        return runPortalProcess(quiet);
+    } else if (role == "stripepay") {
+        return runStripePayProcess(portalCount, quiet);
+    } else if (!role.empty()) {
+        std::cerr << "Unknown role: " << role << std::endl;
+        return 1;
+    }
+    
     std::cout << "Starting Air Traffic Control System Simulation...\n";
     
+    if (!tracePath.empty()) {
+        g_tracer.start(tracePath);
+    }
+    
     ATCSController atcs;
     std::atomic<bool> shouldExit{false};
     
+    if (stressMode) {
+        atcs.setTimeScale(stressConfig.timeScale);
+    }
+    if (gateCount > 0) {
+        atcs.configureGates(gateCount);
+    }
+    atcs.configureArrivals(arrivalProcess, arrivalRate, burstSize);
+    if (!runwayLayout.empty() && !atcs.configureRunways(runwayLayout)) {
+        return 1;
+    }
+    for (const auto& spec : runwayBuffers) {
+        if (!atcs.configureRunwayBuffer(spec)) {
+            return 1;
+        }
+    }
+    for (const auto& spec : faultRates) {
+        if (!atcs.configureGroundFaultRate(spec)) {
+            return 1;
+        }
+    }
+    if (!telemetryPath.empty() && !atcs.enableTelemetry(telemetryPath)) {
+        return 1;
+    }
+    if (!runReportPath.empty()) {
+        atcs.setRunReportPath(runReportPath);
+    }
+    
+    // Optionally resume from a checkpoint instead of warming up again
+    if (!restorePath.empty() && !atcs.restoreCheckpoint(restorePath)) {
+        return 1;
+    }
+    
+    if (multiProcess) {
+        atcs.enableMultiProcess(portalCount, quiet);
+    }
+    
+    // Allocation counting starts with the workload, after setup
+    unsigned int firstFlightNumber = atcs.flightNumbersIssued();
+    if (allocProfile) {
+        AllocTracker::start();
+    }
+    auto allocReport = [&](const char* unit, uint64_t units) {
+        if (!allocProfile) return true;
+        ProfiledLock consoleLock(g_console_mutex);
+        return AllocTracker::report(std::cout, unit, units, allocBudget);
+    };
+    
+    // Benchmark the process pipeline without running the simulation
+    if (ipcBenchCount > 0) {
+        atcs.runIpcBenchmark(ipcBenchCount);
+        bool withinBudget = allocReport("violation", ipcBenchCount);
+        printLockProfile();
+        bip::shared_memory_object::remove("AVNSharedMemory");
+        bip::named_mutex::remove("AVNMutex");
+        return withinBudget ? 0 : 1;
+    }
+    
+    // Benchmark the end-of-run report over synthetic flight history
+    if (reportBenchCount > 0) {
+        atcs.runReportBenchmark(reportBenchCount);
+        bool withinBudget = allocReport("flight", reportBenchCount);
+        printLockProfile();
+        bip::shared_memory_object::remove("AVNSharedMemory");
+        bip::named_mutex::remove("AVNMutex");
+        return withinBudget ? 0 : 1;
+    }
+    
+    // Benchmark the payment queue against the stand-in gateway
+    if (paymentBenchCount > 0) {
+        int status = runPaymentBenchmark(paymentBenchCount, paymentWorkers, gatewayLatency);
+        if (!allocReport("payment", paymentBenchCount)) status = 1;
+        printLockProfile();
+        bip::shared_memory_object::remove("AVNSharedMemory");
+        bip::named_mutex::remove("AVNMutex");
+        return status;
+    }
+    
+    // Batch capacity planning runs in virtual time, also without a session
+    if (monteCarloMode) {
+        auto started = std::chrono::steady_clock::now();
+        auto results = atcs.runMonteCarlo(monteCarloConfig);
+        double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        atcs.printMonteCarloReport(monteCarloConfig, results, wallSeconds);
+        bool withinBudget = allocReport("scenario", monteCarloConfig.scenarios);
+        printLockProfile();
+        bip::shared_memory_object::remove("AVNSharedMemory");
+        bip::named_mutex::remove("AVNMutex");
+        return withinBudget ? 0 : 1;
+    }
+    
+    // Headless saturation test replaces the interactive session
+    if (stressMode) {
+        auto steps = atcs.runSaturationTest(stressConfig);
+        atcs.printSaturationReport(steps);
+        bool withinBudget = allocReport("flight", atcs.flightNumbersIssued() - firstFlightNumber);
+        printLockProfile();
+        bip::shared_memory_object::remove("AVNSharedMemory");
+        bip::named_mutex::remove("AVNMutex");
+        return withinBudget ? 0 : 1;
+    }
+    
     // Start simulation in a separate thread
     std::thread simulationThread(&ATCSController::startSimulation, &atcs);
     
+    // Payments complete in the background; receipts print when they settle
+    PaymentQueue payments(paymentWorkers, gatewayLatency);
+    
+    // A control socket replaces the prompt; the session runs until the
+    // simulated time is up or a client sends shutdown
+    std::unique_ptr<ControlServer> controlServer;
+    if (!controlSocketPath.empty()) {
+        controlServer = std::make_unique<ControlServer>(controlSocketPath, atcs, payments);
+        if (!controlServer->start()) {
+            atcs.stopSimulation();
+        } else if (controlBenchCount > 0) {
+            runControlBenchmark(controlSocketPath, controlBenchCount);
+            atcs.stopSimulation();
+        }
+        shouldExit = true;
+    }
+    
     // Simple command interface for testing
     std::string command;
     while (!shouldExit) {
-        std::cout << "\nEnter command (airline, pay, exit): ";
+        std::cout << "\nEnter command (airline, pay, eta, flight, avnstats, checkpoint, exit): ";
         std::getline(std::cin, command);
         
         if (command == "exit") {
@@ -1354,7 +8442,15 @@ int main() {
                 std::cin >> avnID;
                 std::cin.ignore();
                 
-                portal.payAVN(avnID);
+                double due = portal.amountDue(avnID);
+                if (due < 0) {
+                    std::cout << "AVN #" << avnID << " not found for " << airlineName << std::endl;
+                } else {
+                    // Keyed by AVN, so paying the same AVN again cannot charge twice
+                    payments.submit({"portal-" + airlineName + "-" + std::to_string(avnID), avnID, due},
+                                    StripePay::printReceipt);
+                    std::cout << "Payment for AVN #" << avnID << " queued" << std::endl;
+                }
             }
         } else if (command == "pay") {
             int avnID;
@@ -1366,11 +8462,40 @@ int main() {
             std::cin >> amount;
             std::cin.ignore();
             
-            StripePay stripePay;
-            stripePay.processPayment(avnID, amount);
+            std::string key = "pay-" + std::to_string(avnID) + "-" + std::to_string(std::llround(amount * 100));
+            payments.submit({key, avnID, amount}, StripePay::printReceipt);
+            std::cout << "Payment for AVN #" << avnID << " queued" << std::endl;
+        } else if (command == "eta") {
+            std::string airlineName;
+            std::cout << "Enter airline name: ";
+            std::getline(std::cin, airlineName);
+            atcs.printRunwayETAs(airlineName);
+        } else if (command == "flight") {
+            int flightNumber;
+            std::cout << "Enter flight number: ";
+            std::cin >> flightNumber;
+            std::cin.ignore();
+            atcs.printFlightStatus(flightNumber);
+        } else if (command == "avnstats") {
+            atcs.printAVNAnalytics();
+        } else if (command == "checkpoint") {
+            std::string path;
+            std::cout << "Enter checkpoint file: ";
+            std::getline(std::cin, path);
+            atcs.saveCheckpoint(path);
+        }
+    }
+    
+    if (controlServer) {
+        if (simulationThread.joinable()) {
+            simulationThread.join();
         }
+        controlServer->stop();
     }
     
+    // Settle queued payments before the AVN table goes away
+    payments.shutdown();
+    
     // Clean up shared memory
     bip::shared_memory_object::remove("AVNSharedMemory");
     bip::named_mutex::remove("AVNMutex");
@@ -1379,5 +8504,7 @@ int main() {
         simulationThread.join();
     }
     
-    return 0;
+    bool withinBudget = allocReport("flight", atcs.flightNumbersIssued() - firstFlightNumber);
+    printLockProfile();
+    return withinBudget ? 0 : 1;
 }
\ No newline at end of file